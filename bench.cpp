@@ -0,0 +1,334 @@
+// bench.cpp
+// MiniLang benchmark harness: scalable workload generator, per-phase timing with
+// allocation counts and peak RSS, JSON reports, and comparison of two reports
+// Compile: g++ -std=c++17 bench.cpp -o bench -O2 -pthread
+
+#define MINILANG_NO_MAIN
+#include "minilang.cpp"
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// ============================================================================
+// WORKLOAD GENERATOR
+// ============================================================================
+// Each workload grows along one axis with `scale`; all of them are valid
+// MiniLang (every variable is assigned before use) and never overflow.
+static const char *WORKLOADS[] = { "nesting", "straightline", "variables", "loop", "print" };
+static const long long DEFAULT_SCALE[] = { 1000, 200000, 50000, 1000000, 1000000 };
+
+bool generateWorkload(const string &kind, long long scale, ostream &out){
+    if(kind == "nesting"){
+        // Alternating if / single-trip while blocks, `scale` levels deep.
+        out << "v0 = 1;\n";
+        for(long long d = 1; d <= scale; d++){
+            string indent(2 * (d - 1), ' ');
+            if(d % 2){
+                out << indent << "if (v" << d - 1 << " > 0) {\n";
+            } else {
+                out << indent << "w" << d << " = 0;\n";
+                out << indent << "while (w" << d << " < 1) {\n";
+                out << indent << "  w" << d << " = w" << d << " + 1;\n";
+            }
+            out << indent << "  v" << d << " = v" << d - 1 << " + " << d % 7 << ";\n";
+        }
+        out << string(2 * scale, ' ') << "print(v" << scale << ");\n";
+        for(long long d = scale; d >= 1; d--) out << string(2 * (d - 1), ' ') << "}\n";
+        out << "print(v0);\n";
+    } else if(kind == "straightline"){
+        // `scale` assignments cycling over sixteen variables.
+        for(int k = 0; k < 16; k++) out << "s" << k << " = " << k + 1 << ";\n";
+        for(long long i = 0; i < scale; i++)
+            out << "s" << i % 16 << " = (s" << (i + 3) % 16 << " * 3 + s" << (i + 7) % 16
+                << " - " << i % 97 << ") % 1000003;\n";
+        out << "print(s0 + s5 + s10 + s15);\n";
+    } else if(kind == "variables"){
+        // `scale` distinct variables, each defined from the previous one.
+        out << "x0 = 1;\n";
+        for(long long i = 1; i < scale; i++) out << "x" << i << " = (x" << i - 1 << " + " << i << ") % 1000003;\n";
+        out << "print(x" << scale - 1 << ");\n";
+    } else if(kind == "loop"){
+        // One loop with `scale` trips.
+        out << "i = 0;\nacc = 0;\nwhile (i < " << scale << ") {\n"
+            << "  acc = (acc + i * 3) % 1000003;\n"
+            << "  if (i % 7 == 0) {\n    acc = acc + 1;\n  }\n"
+            << "  i = i + 1;\n}\nprint(acc);\n";
+    } else if(kind == "print"){
+        // `scale` print statements executed by one loop.
+        out << "i = 0;\nwhile (i < " << scale << ") {\n  print(i);\n  i = i + 1;\n}\n";
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// PHASE HARNESS
+// ============================================================================
+struct BenchOptions {
+    int reps = 10;
+    string engine = "ast";      // ast, vm or jit
+    int optLevel = 0;
+};
+
+struct PhaseSamples {
+    string name;
+    vector<double> ms;
+    vector<size_t> allocations;
+};
+
+struct BenchResult {
+    string workload;
+    long long scale = 0;
+    size_t sourceBytes = 0;
+    vector<PhaseSamples> phases;
+    long peakRssKb = 0;
+};
+
+// Times one phase and records its duration and allocation count under `name`
+// (allocationCount is the counter behind minilang's --profile).
+template<class F> void timePhase(BenchResult &r, size_t &slot, const string &name, F &&body){
+    if(slot == r.phases.size()) r.phases.push_back({name, {}, {}});
+    size_t allocs = allocationCount;
+    auto start = chrono::steady_clock::now();
+    body();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    r.phases[slot].ms.push_back(ms);
+    r.phases[slot].allocations.push_back(allocationCount - allocs);
+    slot++;
+}
+
+// Runs the whole pipeline `reps` times; each repetition starts again from
+// the source text, because folding rewrites the AST in place.
+BenchResult runWorkload(const string &name, long long scale, string_view source, const BenchOptions &opts){
+    BenchResult r;
+    r.workload = name;
+    r.scale = scale;
+    r.sourceBytes = source.size();
+#ifdef MINILANG_HAVE_POSIX
+    programOut.fd = open("/dev/null", O_WRONLY);
+#endif
+    for(int rep = 0; rep < opts.reps; rep++){
+        size_t slot = 0;
+        timePhase(r, slot, "lex", [&]{
+            Lexer lex(source);
+            while(lex.nextToken().type != TokenType::END) {}
+        });
+        Ast ast;
+        timePhase(r, slot, "parse", [&]{ ast = Parser(source).parseProgram(); });
+        timePhase(r, slot, "semantic", [&]{
+            vector<bool> defined(ast.names.size(), false);
+            semanticCheckBlock(ast, ast.root, defined, false);
+        });
+        timePhase(r, slot, "fold", [&]{ foldConstantsInBlock(ast, ast.root, false); });
+        TACGen gen(ast.names);
+        timePhase(r, slot, "tacgen", [&]{ gen.genProgram(ast); });
+        if(opts.optLevel > 0)
+            timePhase(r, slot, "optimize", [&]{ optimizeTAC(gen.prog, opts.optLevel, false, false); });
+        if(opts.engine == "vm"){
+            Bytecode bc;
+            timePhase(r, slot, "bytecode", [&]{ bc = BytecodeCompiler(ast).compile(); });
+            timePhase(r, slot, "execute", [&]{ runBytecode(bc); programOut.flush(); });
+        } else if(opts.engine == "jit"){
+            timePhase(r, slot, "execute", [&]{ TieredExecutor(gen.prog).run(); programOut.flush(); });
+        } else {
+            timePhase(r, slot, "execute", [&]{
+                Frame env(ast.names.size());
+                AstInterpreter(ast, env).exec(ast.root);
+                programOut.flush();
+            });
+        }
+    }
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    r.peakRssKb = ru.ru_maxrss;
+    return r;
+}
+
+double percentile(vector<double> v, double p){
+    sort(v.begin(), v.end());
+    size_t k = (size_t)ceil(p * v.size());
+    return v[k ? k - 1 : 0];
+}
+
+double median(vector<double> v){
+    sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+// One object per workload and one line per phase, so `compare` (and grep)
+// can read the report back line by line.
+void writeJson(const BenchResult &r, const BenchOptions &opts, ostream &out){
+    out << fixed << setprecision(3);
+    out << "  {\"workload\": \"" << r.workload << "\", \"scale\": " << r.scale << ", \"engine\": \"" << opts.engine
+        << "\", \"opt_level\": " << opts.optLevel << ", \"reps\": " << opts.reps << ", \"source_bytes\": "
+        << r.sourceBytes << ", \"peak_rss_kb\": " << r.peakRssKb << ", \"phases\": [\n";
+    for(size_t k = 0; k < r.phases.size(); k++){
+        const PhaseSamples &p = r.phases[k];
+        vector<double> allocs(p.allocations.begin(), p.allocations.end());
+        out << "    {\"phase\": \"" << p.name << "\", \"median_ms\": " << median(p.ms) << ", \"p95_ms\": "
+            << percentile(p.ms, 0.95) << ", \"allocations\": " << (long long)median(allocs) << "}"
+            << (k + 1 < r.phases.size() ? "," : "") << "\n";
+    }
+    out << "  ]}";
+}
+
+// ============================================================================
+// REPORT COMPARISON
+// ============================================================================
+// Value of "key" on a report line, as text (quotes stripped), or "".
+string jsonField(const string &line, const string &key){
+    size_t at = line.find("\"" + key + "\": ");
+    if(at == string::npos) return "";
+    at += key.size() + 4;
+    if(line[at] == '"') return line.substr(at + 1, line.find('"', at + 1) - at - 1);
+    return line.substr(at, line.find_first_of(",}", at) - at);
+}
+
+struct PhaseStats { double median, p95; long long allocations; };
+
+map<string, PhaseStats> readReport(const string &path){
+    ifstream in(path);
+    if(!in){
+        cerr<<"[BENCH ERROR] Cannot open report: "<<path<<"\n";
+        exit(1);
+    }
+    map<string, PhaseStats> stats;
+    string line, workload;
+    while(getline(in, line)){
+        if(!jsonField(line, "workload").empty())
+            workload = jsonField(line, "workload") + "/" + jsonField(line, "engine") + "/O" + jsonField(line, "opt_level");
+        else if(!jsonField(line, "phase").empty())
+            stats[workload + "/" + jsonField(line, "phase")] = {
+                stod(jsonField(line, "median_ms")), stod(jsonField(line, "p95_ms")), stoll(jsonField(line, "allocations")) };
+    }
+    return stats;
+}
+
+// Prints old and new medians side by side.  A phase regresses when its median
+// grows by more than `threshold` percent (and by at least 0.05 ms, to ignore
+// timer noise on tiny phases) or when it allocates more; returns the count.
+int compareReports(const string &oldPath, const string &newPath, double threshold){
+    auto before = readReport(oldPath), after = readReport(newPath);
+    int regressions = 0;
+    printf("%-36s %12s %12s %8s %10s %10s\n", "workload/engine/opt/phase", "old ms", "new ms", "change", "old alloc", "new alloc");
+    for(auto &[key, o] : before){
+        auto it = after.find(key);
+        if(it == after.end()) continue;
+        const PhaseStats &n = it->second;
+        double change = o.median > 0 ? (n.median - o.median) * 100 / o.median : 0;
+        bool slower = change > threshold && n.median - o.median > 0.05;
+        bool moreAllocs = n.allocations > o.allocations;
+        printf("%-36s %12.3f %12.3f %+7.1f%% %10lld %10lld%s\n", key.c_str(), o.median, n.median, change,
+               o.allocations, n.allocations, slower || moreAllocs ? "  REGRESSION" : "");
+        regressions += slower || moreAllocs;
+    }
+    printf("%d regression(s) above %.1f%%\n", regressions, threshold);
+    return regressions;
+}
+
+// ============================================================================
+// COMMAND LINE
+// ============================================================================
+void usage(){
+    cout << "MiniLang benchmark harness\n";
+    cout << "  ./bench gen WORKLOAD SCALE           Write a generated program to stdout\n";
+    cout << "  ./bench run [options] WORKLOAD SCALE Time each phase on a generated program\n";
+    cout << "  ./bench run [options] FILE           Time each phase on a program file\n";
+    cout << "  ./bench suite [options]              Run every workload at its default scale\n";
+    cout << "  ./bench compare OLD NEW [PCT]        Compare two reports; exit 1 on regressions (default 10%)\n";
+    cout << "Workloads: nesting, straightline, variables, loop, print\n";
+    cout << "Options:\n";
+    cout << "  -r N                Repetitions per phase (default 10)\n";
+    cout << "  --engine ast|vm|jit Execution engine (default ast)\n";
+    cout << "  -O1, -O2            Also time the SSA optimizer, and execute its output with --engine jit\n";
+    cout << "  --scale-factor F    Multiply the default suite scales by F\n";
+}
+
+int main(int argc, char **argv){
+    if(argc < 2){
+        usage();
+        return 1;
+    }
+    string cmd = argv[1];
+    if(cmd == "compare"){
+        if(argc < 4){
+            usage();
+            return 1;
+        }
+        return compareReports(argv[2], argv[3], argc > 4 ? atof(argv[4]) : 10.0) ? 1 : 0;
+    }
+    if(cmd == "gen"){
+        if(argc < 4 || !generateWorkload(argv[2], atoll(argv[3]), cout)){
+            cerr<<"[BENCH ERROR] Unknown workload or missing scale\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    BenchOptions opts;
+    double scaleFactor = 1;
+    vector<string> args;
+    for(int ai = 2; ai < argc; ai++){
+        string arg = argv[ai];
+        if(arg == "-r" && ai + 1 < argc) opts.reps = max(1, atoi(argv[++ai]));
+        else if(arg == "--engine" && ai + 1 < argc) opts.engine = argv[++ai];
+        else if(arg == "-O1" || arg == "-O2") opts.optLevel = arg[2] - '0';
+        else if(arg == "--scale-factor" && ai + 1 < argc) scaleFactor = atof(argv[++ai]);
+        else args.push_back(arg);
+    }
+    if(opts.engine != "ast" && opts.engine != "vm" && opts.engine != "jit"){
+        cerr<<"[BENCH ERROR] Unknown engine: "<<opts.engine<<"\n";
+        return 1;
+    }
+
+    // Workloads to run, as (name, scale); scale 0 means a program file.
+    vector<pair<string, long long>> jobs;
+    if(cmd == "suite"){
+        for(int k = 0; k < 5; k++) jobs.push_back({WORKLOADS[k], max(1LL, (long long)(DEFAULT_SCALE[k] * scaleFactor))});
+    } else if(cmd == "run" && args.size() == 2){
+        jobs.push_back({args[0], atoll(args[1].c_str())});
+    } else if(cmd == "run" && args.size() == 1){
+        jobs.push_back({args[0], 0});
+    } else {
+        usage();
+        return 1;
+    }
+
+    // Each workload runs in a child process so its peak RSS is its own.
+    cout << "[\n";
+    for(size_t j = 0; j < jobs.size(); j++){
+        cout.flush();
+        pid_t pid = fork();
+        if(pid == 0){
+            string text;
+            SourceFile file;
+            string_view source;
+            if(jobs[j].second == 0){
+                loadFile(jobs[j].first, file);
+                source = file.text;
+            } else {
+                ostringstream gen;
+                if(!generateWorkload(jobs[j].first, jobs[j].second, gen)){
+                    cerr<<"[BENCH ERROR] Unknown workload: "<<jobs[j].first<<"\n";
+                    _exit(1);
+                }
+                text = gen.str();
+                source = text;
+            }
+            BenchResult r = runWorkload(jobs[j].first, jobs[j].second, source, opts);
+            writeJson(r, opts, cout);
+            cout << (j + 1 < jobs.size() ? ",\n" : "\n");
+            cout.flush();
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+            cerr<<"[BENCH ERROR] Workload "<<jobs[j].first<<" failed\n";
+            return 1;
+        }
+    }
+    cout << "]\n";
+    return 0;
+}
@@ -0,0 +1,24 @@
+#!/bin/bash
+
+# Lexer throughput benchmark: builds a large program by repeating the
+# bundled examples and reports how fast ./minilang --bench-lexer tokenizes it.
+# SIZE_MB sets the approximate size of the generated program (default 64).
+
+MINILANG=${MINILANG:-./minilang}
+SIZE_MB=${SIZE_MB:-64}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$MINILANG" ]; then
+    echo "Error: $MINILANG not found; run ./setup.sh first"
+    exit 1
+fi
+
+# Double the concatenated examples until the file is large enough
+cat *.minilang > "$WORK/big.minilang"
+while [ "$(wc -c < "$WORK/big.minilang")" -lt $((SIZE_MB * 1000000)) ]; do
+    cat "$WORK/big.minilang" "$WORK/big.minilang" > "$WORK/next.minilang"
+    mv "$WORK/next.minilang" "$WORK/big.minilang"
+done
+
+"$MINILANG" --bench-lexer "$WORK/big.minilang"
@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# Loop optimization benchmark: runs scaled-up copies of the bundled
+# examples through the TAC interpreter at -O1 and -O2 and compares the
+# number of TAC instructions executed (LICM and strength reduction are -O2).
+
+MINILANG=${MINILANG:-./minilang}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$MINILANG" ]; then
+    echo "Error: $MINILANG not found; run ./setup.sh first"
+    exit 1
+fi
+
+# Scale the loop bounds of the examples up
+sed 's/^n = 8;/n = 200000;/' arithmetic.minilang > "$WORK/arithmetic.minilang"
+sed 's/^n = 10;/n = 1000;/' primes.minilang > "$WORK/primes.minilang"
+sed 's/^n = 6;/n = 400;/' geometric.minilang > "$WORK/geometric.minilang"
+sed 's/^n = 7;/n = 200000;/' triangular.minilang > "$WORK/triangular.minilang"
+
+# Prints "<instructions> <multiplications>" from the --count report
+count() {
+    "$MINILANG" "$@" | sed -n 's/^\[STATS\] Executed \([0-9]*\) TAC instructions (\([0-9]*\) multiplications)$/\1 \2/p'
+}
+
+output() {
+    "$MINILANG" "$@" | sed -n '/^---------------$/,/^---------------$/p'
+}
+
+printf "%-22s %12s %12s %7s %12s %12s\n" "program" "-O1 instrs" "-O2 instrs" "saved" "-O1 muls" "-O2 muls"
+status=0
+for f in "$WORK"/*.minilang; do
+    name=$(basename "$f")
+    read o1 m1 <<< "$(count --count -O1 "$f")"
+    read o2 m2 <<< "$(count --count -O2 "$f")"
+    if [ "$(output --count -O1 "$f")" != "$(output --count -O2 "$f")" ]; then
+        echo "Error: $name prints different output at -O1 and -O2"
+        status=1
+    fi
+    printf "%-22s %12s %12s %6s%% %12s %12s\n" "$name" "$o1" "$o2" "$(( (o1 - o2) * 100 / o1 ))" "$m1" "$m2"
+done
+exit $status
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# Print throughput benchmark: runs a program that prints COUNT numbers
+# (default 10^8) on each engine in --quiet and --binary mode, discarding
+# the output, and reports the wall time of each run.
+
+MINILANG=${MINILANG:-./minilang}
+COUNT=${COUNT:-100000000}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$MINILANG" ]; then
+    echo "Error: $MINILANG not found; run ./setup.sh first"
+    exit 1
+fi
+
+cat > "$WORK/print.minilang" << MINI
+i = 0;
+while (i < $COUNT) {
+  print(i);
+  i = i + 1;
+}
+MINI
+
+TIMEFORMAT="%R"
+printf "%-10s %-9s %10s\n" "engine" "mode" "seconds"
+for engine in "" "--vm" "--jit"; do
+    for mode in --quiet --binary; do
+        secs=$( { time "$MINILANG" $mode $engine "$WORK/print.minilang" > /dev/null; } 2>&1 )
+        printf "%-10s %-9s %10s\n" "${engine:-ast}" "${mode#--}" "$secs"
+    done
+done
@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# Vectorized loop benchmark: runs the arithmetic and triangular examples with
+# n = COUNT (default 10^8) on the AST interpreter on one thread, once one
+# iteration at a time (--no-simd) and once in batches through the lane
+# kernels, discarding the output, and reports the wall times and speedup.
+
+MINILANG=${MINILANG:-./minilang}
+COUNT=${COUNT:-100000000}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$MINILANG" ]; then
+    echo "Error: $MINILANG not found; run ./setup.sh first"
+    exit 1
+fi
+
+sed "s/^n = 8;/n = $COUNT;/" arithmetic.minilang > "$WORK/arithmetic.minilang"
+sed "s/^n = 7;/n = $COUNT;/" triangular.minilang > "$WORK/triangular.minilang"
+
+TIMEFORMAT="%R"
+printf "%-22s %-9s %10s %10s %8s\n" "program" "mode" "scalar s" "simd s" "speedup"
+status=0
+for f in "$WORK"/*.minilang; do
+    name=$(basename "$f")
+    for mode in --quiet --binary; do
+        scalar=$( { time "$MINILANG" -j 1 --no-simd $mode "$f" > /dev/null; } 2>&1 )
+        simd=$( { time "$MINILANG" -j 1 $mode "$f" > /dev/null; } 2>&1 )
+        if ! cmp -s <("$MINILANG" -j 1 --no-simd $mode "$f") <("$MINILANG" -j 1 $mode "$f"); then
+            echo "Error: $name prints different output with --no-simd"
+            status=1
+        fi
+        printf "%-22s %-9s %10s %10s %7sx\n" "$name" "${mode#--}" "$scalar" "$simd" "$(awk "BEGIN { printf \"%.1f\", $scalar / $simd }")"
+    done
+done
+exit $status
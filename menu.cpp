@@ -1,15 +1,137 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <cstdlib>
+#include <cerrno>
+#include <cstring>
 #include <map>
+#include <thread>
+#include <chrono>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace std;
 
+// The menu is a client of a resident `minilang --serve` process, which keeps
+// compiled programs cached between runs; the server is started (and the
+// compiler built, if missing or older than minilang.cpp) the first time it
+// is needed.
+string socketPath() {
+    if (const char *path = getenv("MINILANG_SOCKET")) return path;
+    return "/tmp/minilang-" + to_string(getuid()) + ".sock";
+}
+
+int connectServer(const string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof addr.sun_path - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (sockaddr*)&addr, sizeof addr) == 0) return fd;
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+// A binary older than the source may predate --serve and exit on the flag.
+bool needsBuild(const string& compilerPath) {
+    struct stat bin, src;
+    if (access(compilerPath.c_str(), X_OK) != 0 || stat(compilerPath.c_str(), &bin) != 0) return true;
+    return stat("minilang.cpp", &src) == 0 && src.st_mtime > bin.st_mtime;
+}
+
+bool sendAll(int fd, const string& data) {
+    for (size_t sent = 0; sent < data.size(); ) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+int startServer(const string& compilerPath, const string& path) {
+    if (needsBuild(compilerPath)) {
+        cout << "Building " << compilerPath << "...\n";
+        system(("g++ -std=c++17 -O2 -pthread minilang.cpp -o " + compilerPath).c_str());
+    }
+    cout.flush();    // or the child would write it out a second time
+    pid_t pid = fork();
+    if (pid == 0) {
+        setsid();
+        freopen("/dev/null", "r", stdin);
+        freopen("/dev/null", "w", stdout);
+        freopen("/dev/null", "w", stderr);
+        execl(compilerPath.c_str(), compilerPath.c_str(), "--serve", path.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    for (int attempt = 0; attempt < 250; attempt++) {
+        int fd = connectServer(path);
+        if (fd >= 0) return fd;
+        int status;
+        if (pid > 0 && waitpid(pid, &status, WNOHANG) == pid) {
+            // Another client may have started a server in the meantime.
+            fd = connectServer(path);
+            if (fd >= 0) return fd;
+            cout << compilerPath << " --serve exited during startup";
+            if (WIFEXITED(status)) cout << " with status " << WEXITSTATUS(status);
+            cout << "\n";
+            return -1;
+        }
+        this_thread::sleep_for(chrono::milliseconds(20));
+    }
+    return -1;
+}
+
 void runSnippet(const string& snippetName, const string& compilerPath) {
-    string command = compilerPath + " " + snippetName + ".minilang";
+    string file = snippetName + ".minilang";
     cout << "\n=== Running " << snippetName << " ===\n";
+    ifstream in(file);
+    if (!in) {
+        cout << "Cannot open file: " << file << "\n";
+        cout << "===================\n";
+        return;
+    }
+    stringstream source;
+    source << in.rdbuf();
+
+    string path = socketPath();
+    int fd = connectServer(path);
+    if (fd < 0) fd = startServer(compilerPath, path);
+    if (fd < 0) {
+        cout << "Cannot reach the MiniLang server at " << path << "\n";
+        cout << "===================\n";
+        return;
+    }
+    // Request: an options line, then the source; the reply is the output
+    // followed by a status line, which is held back until the end.
+    string request = "\n" + source.str();
+    if (!sendAll(fd, request)) {
+        close(fd);
+        cout << "Cannot send the program to the MiniLang server\n";
+        cout << "===================\n";
+        return;
+    }
+    shutdown(fd, SHUT_WR);
+
     cout << "Output:\n";
-    system(command.c_str());
+    string pending;
+    char buf[4096];
+    for (ssize_t n; (n = read(fd, buf, sizeof buf)) > 0; ) {
+        pending.append(buf, n);
+        size_t last = pending.rfind('\n');
+        if (last == string::npos || last == 0) continue;
+        size_t keep = pending.rfind('\n', last - 1);
+        if (keep == string::npos) continue;
+        cout << pending.substr(0, keep + 1);
+        pending.erase(0, keep + 1);
+    }
+    close(fd);
+    cout << pending.substr(0, pending.rfind('#'));
+    if (pending.find("#OK") == string::npos) cout << "(program failed)\n";
+    cout.flush();
     cout << "===================\n";
 }
 
@@ -39,9 +161,6 @@ int main() {
         {5, "triangular"},
     };
 
-    // First, compile the compiler if not exists
-    system("g++ minilang.cpp -o minilang -std=c++17");
-
     int choice;
     string customFile;
 
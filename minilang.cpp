@@ -1,14 +1,47 @@
 // minilang.cpp
 // Single-file MiniLang: lexer, parser, AST, semantic checks, constant-folding, TAC, interpreter, CLI
-// Compile: g++ -std=c++17 minilang.cpp -O2 -o minilang
+// Compile: g++ -std=c++17 minilang.cpp -O2 -o minilang -pthread
 
 #include <bits/stdc++.h>
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#include <sys/mman.h>
+#define MINILANG_HAVE_JIT 1
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#define MINILANG_HAVE_POSIX 1
+#endif
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define MINILANG_HAVE_SSE2 1
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define MINILANG_HAVE_AVX2 1    // loop kernels are built for AVX2 and picked at run time
+#endif
 using namespace std;
 
+// Compile and runtime errors are written to errs() and end the run with
+// fail().  A --batch job points errs() at its own buffer, and fail() then
+// throws JobFailed so that only that job stops.
+struct JobFailed {};
+static thread_local ostream *jobErrors = nullptr;
+inline ostream &errs(){ return jobErrors ? *jobErrors : cerr; }
+[[noreturn]] inline void fail(){
+    if(jobErrors) throw JobFailed();
+    exit(1);
+}
+
 // ============================================================================
 // PHASE 0: LANGUAGE SPECIFICATION
 // ============================================================================
-static const char *MINILANG_SPEC = R"SPEC(
+static const char MINILANG_SPEC[] = R"SPEC(
 [MiniLang specification remains the same...]
 )SPEC";
 
@@ -25,725 +58,6159 @@ enum class TokenType {
 };
 
 string tokenTypeName(TokenType t) {
-    // [Implementation remains the same...]
+    static const char *names[] = {
+        "END", "INT_LIT", "IDENT",
+        "PLUS", "MINUS", "MUL", "DIV", "MOD",
+        "ASSIGN", "EQ", "NEQ", "LT", "GT", "LTE", "GTE",
+        "LPAREN", "RPAREN", "LBRACE", "RBRACE", "SEMI",
+        "KW_PRINT", "KW_IF", "KW_ELSE", "KW_WHILE",
+    };
+    return names[static_cast<int>(t)];
 }
 
+// Tokens never own text: `text` is a slice of the source buffer, which
+// outlives the lexer, parser and AST.
 struct Token { 
     TokenType type; 
-    string text; 
+    string_view text; 
     long long intVal; 
     int line;
-    Token(TokenType t=TokenType::END, string s="", int l=1): type(t), text(s), intVal(0), line(l) {} 
+    bool big = false;       // --bigint: literal beyond 64 bits, intVal unset
+    Token(TokenType t=TokenType::END, string_view s="", int l=1): type(t), text(s), intVal(0), line(l) {} 
 };
 
 // ============================================================================
 // LEXER IMPLEMENTATION
 // ============================================================================
+// Character classes for the DFA's start state; one table lookup replaces the
+// <cctype> calls and the operator probes.
+enum CharClass : uint8_t { CC_INVALID, CC_END, CC_SPACE, CC_DIGIT, CC_IDENT, CC_SLASH, CC_CMP, CC_SINGLE };
+
+struct LexTables {
+    uint8_t cls[256];
+    TokenType single[256];     // one-character token, or END if there is none
+    TokenType withEq[256];     // token for "c=" when c is CC_CMP
+
+    constexpr LexTables(): cls(), single(), withEq() {
+        for(int c = 0; c < 256; c++){ cls[c] = CC_INVALID; single[c] = withEq[c] = TokenType::END; }
+        cls[0] = CC_END;
+        for(char c : {' ', '\t', '\n', '\v', '\f', '\r'}) cls[(int)c] = CC_SPACE;
+        for(int c = '0'; c <= '9'; c++) cls[c] = CC_DIGIT;
+        for(int c = 'a'; c <= 'z'; c++) cls[c] = cls[c - 'a' + 'A'] = CC_IDENT;
+        cls['_'] = CC_IDENT;
+        cls['/'] = CC_SLASH;
+        const char ops[] = "+-*/%(){};";
+        const TokenType opTypes[] = { TokenType::PLUS, TokenType::MINUS, TokenType::MUL, TokenType::DIV, TokenType::MOD,
+                                      TokenType::LPAREN, TokenType::RPAREN, TokenType::LBRACE, TokenType::RBRACE, TokenType::SEMI };
+        for(int k = 0; k < 10; k++){
+            if(ops[k] != '/') cls[(int)ops[k]] = CC_SINGLE;
+            single[(int)ops[k]] = opTypes[k];
+        }
+        const char cmps[] = "=!<>";
+        const TokenType alone[] = { TokenType::ASSIGN, TokenType::END, TokenType::LT, TokenType::GT };
+        const TokenType eq[] = { TokenType::EQ, TokenType::NEQ, TokenType::LTE, TokenType::GTE };
+        for(int k = 0; k < 4; k++){
+            cls[(int)cmps[k]] = CC_CMP;
+            single[(int)cmps[k]] = alone[k];
+            withEq[(int)cmps[k]] = eq[k];
+        }
+    }
+};
+static constexpr LexTables lexTables;
+
+// Perfect hash over the keywords: (length + first char) & 7 is distinct for
+// print, if, else and while, so one comparison decides.
+struct Keyword { string_view text; TokenType type; };
+static constexpr Keyword keywordTable[8] = {
+    {}, {"else", TokenType::KW_ELSE}, {}, {"if", TokenType::KW_IF},
+    {"while", TokenType::KW_WHILE}, {"print", TokenType::KW_PRINT}, {}, {},
+};
+
+constexpr TokenType keywordType(string_view s){
+    const Keyword &k = keywordTable[(s.size() + (unsigned char)s[0]) & 7];
+    return k.text == s ? k.type : TokenType::IDENT;
+}
+static_assert(keywordType("print")==TokenType::KW_PRINT && keywordType("if")==TokenType::KW_IF &&
+              keywordType("else")==TokenType::KW_ELSE && keywordType("while")==TokenType::KW_WHILE,
+              "keyword hash must be perfect");
+
+// Program text read from a file in fixed-size chunks, for --stream.  Only
+// the unconsumed tail of the buffer is kept, so memory does not grow with
+// the size of the file.
+struct StreamSource {
+    FILE *in = nullptr;
+    string buf;
+    static constexpr size_t CHUNK = 1 << 20;
+
+    StreamSource() = default;
+    StreamSource(const StreamSource&) = delete;
+    StreamSource &operator=(const StreamSource&) = delete;
+    ~StreamSource(){ if(in) fclose(in); }
+
+    // Drops buf[0, drop) and appends the next chunk; false once the input
+    // is exhausted (the drop still happens).
+    bool refill(size_t drop){
+        buf.erase(0, drop);
+        if(!in) return false;
+        size_t old = buf.size();
+        buf.resize(old + CHUNK);
+        size_t n = fread(&buf[old], 1, CHUNK, in);
+        buf.resize(old + n);
+        if(n == 0){
+            fclose(in);
+            in = nullptr;
+        }
+        return n > 0;
+    }
+};
+
 struct Lexer {
-    string src; 
+    string_view src; 
     size_t i=0; 
     int line=1;
     bool debug;
+    bool bigint = false;        // --bigint: accept literals of any length
+    StreamSource *stream = nullptr;
+    size_t tokenStart = 0;      // first byte of the token being scanned
     
-    Lexer(const string &s, bool dbg=false): src(s), debug(dbg) { 
+    Lexer(string_view s, bool dbg=false): src(s), debug(dbg) { 
         if(debug) cout << "[LEXER] Initialized with source length: " << src.length() << endl;
     }
+
+    // Streaming lexer: `src` is a window onto stream->buf that is refilled
+    // whenever a scan runs off its end.  Bytes before tokenStart are dropped
+    // then, so a token's text stays valid only until the next nextToken().
+    Lexer(StreamSource &in, bool dbg=false): debug(dbg), stream(&in) {
+        if(debug) cout << "[LEXER] Initialized for streaming input" << endl;
+    }
+
+    // Drops the consumed prefix and rebases the positions; false at end of input.
+    bool refill(size_t drop){
+        bool more = stream->refill(drop);
+        src = stream->buf;
+        i -= drop;
+        tokenStart -= drop;
+        return more;
+    }
     
-    char peek(){ return i < src.size() ? src[i] : '\0'; }
-    char get(){ return i < src.size() ? src[i++] : '\0'; }
-    bool startswith(const string &pat){ return src.substr(i, pat.size()) == pat; }
+    uint8_t classAt(size_t k){
+        while(k >= src.size()){
+            size_t drop = tokenStart;
+            if(!stream || !refill(drop)) return CC_END;
+            k -= drop;
+        }
+        return lexTables.cls[(unsigned char)src[k]];
+    }
+
+#if MINILANG_HAVE_SSE2
+    // Bit k is set when byte i+k is in [lo, lo+n).  Needs 16 readable bytes.
+    unsigned rangeMask16(char lo, char n) const {
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(src.data() + i)), _mm_set1_epi8(lo));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(n - 1)), v));
+    }
+    unsigned byteMask16(char c) const {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(src.data() + i)), _mm_set1_epi8(c)));
+    }
+#endif
+
+    // Whitespace, comment bodies and digit runs are skipped 16 bytes at a
+    // time with SSE2; the scalar loops finish the last partial block.  Most
+    // runs in ordinary code are one or two bytes long, so whitespace and
+    // digits go vector-wide only once a run reaches its third byte.
+    void skipWhitespace(){
+        for(int k = 0; k < 2; k++){
+            if(classAt(i)!=CC_SPACE) return;
+            if(src[i++]=='\n') line++;
+        }
+#if MINILANG_HAVE_SSE2
+        while(i + 16 <= src.size()){
+            unsigned ws = rangeMask16('\t', 5) | byteMask16(' ');
+            unsigned len = ws == 0xFFFF ? 16 : __builtin_ctz(~ws);
+            line += __builtin_popcount(byteMask16('\n') & ((1u << len) - 1));
+            i += len;
+            if(len < 16) return;
+        }
+#endif
+        while(classAt(i)==CC_SPACE){ if(src[i]=='\n') line++; i++; tokenStart = i; }
+    }
+
+    void skipComment(){
+#if MINILANG_HAVE_SSE2
+        while(i + 16 <= src.size()){
+            unsigned stop = byteMask16('\n') | byteMask16('\0');
+            if(stop){ i += __builtin_ctz(stop); return; }
+            i += 16;
+        }
+#endif
+        for(;; i++){
+            tokenStart = i;
+            if(classAt(i)==CC_END || src[i]=='\n') return;
+        }
+    }
+
+    void skipDigits(){
+        for(int k = 0; k < 2; k++){
+            if(classAt(i)!=CC_DIGIT) return;
+            i++;
+        }
+#if MINILANG_HAVE_SSE2
+        while(i + 16 <= src.size()){
+            unsigned digits = rangeMask16('0', 10);
+            if(digits != 0xFFFF){ i += __builtin_ctz(~digits); return; }
+            i += 16;
+        }
+#endif
+        while(classAt(i)==CC_DIGIT) i++;
+    }
     
     Token nextToken(){
         while(true){
-            char c = peek();
-            if(c=='\0') {
-                if(debug) cout << "[LEXER] End of file reached" << endl;
-                return Token(TokenType::END, "", line);
-            }
-            if(isspace(static_cast<unsigned char>(c))){ 
-                if(c=='\n') line++; 
-                get(); 
-                continue; 
-            }
-            if(startswith("//")){ 
-                if(debug) cout << "[LEXER] Skipping comment" << endl;
-                while(peek() && peek()!='\n') get(); 
-                continue; 
-            }
-            if(isdigit(static_cast<unsigned char>(c))){ 
-                string s; 
-                while(isdigit(static_cast<unsigned char>(peek()))) s.push_back(get()); 
-                Token t(TokenType::INT_LIT, s, line); 
-                t.intVal = stoll(s); 
-                if(debug) cout << "[LEXER] Integer literal: " << s << " (value: " << t.intVal << ")" << endl;
-                return t; 
-            }
-            if(isalpha(static_cast<unsigned char>(c)) || c=='_'){ 
-                string s; 
-                while(isalnum(static_cast<unsigned char>(peek())) || peek()=='_') s.push_back(get()); 
-                Token t(TokenType::IDENT, s, line);
-                if(s=="print") { t.type = TokenType::KW_PRINT; if(debug) cout << "[LEXER] Keyword: print" << endl; }
-                else if(s=="if") { t.type = TokenType::KW_IF; if(debug) cout << "[LEXER] Keyword: if" << endl; }
-                else if(s=="else") { t.type = TokenType::KW_ELSE; if(debug) cout << "[LEXER] Keyword: else" << endl; }
-                else if(s=="while") { t.type = TokenType::KW_WHILE; if(debug) cout << "[LEXER] Keyword: while" << endl; }
-                else { if(debug) cout << "[LEXER] Identifier: " << s << endl; }
-                return t; 
-            }
-            if(startswith("==")){ i+=2; if(debug) cout << "[LEXER] Operator: ==" << endl; return Token(TokenType::EQ, "==", line); }
-            if(startswith("!=")){ i+=2; if(debug) cout << "[LEXER] Operator: !=" << endl; return Token(TokenType::NEQ, "!=", line); }
-            if(startswith("<=")){ i+=2; if(debug) cout << "[LEXER] Operator: <=" << endl; return Token(TokenType::LTE, "<=", line); }
-            if(startswith(">=")){ i+=2; if(debug) cout << "[LEXER] Operator: >=" << endl; return Token(TokenType::GTE, ">=", line); }
+            tokenStart = i;
+            uint8_t cls = classAt(i);
+            switch(cls){
+                case CC_END:
+                    if(debug) cout << "[LEXER] End of file reached" << endl;
+                    return Token(TokenType::END, "", line);
+                case CC_SPACE:
+                    skipWhitespace();
+                    continue;
+                case CC_DIGIT: {
+                    skipDigits();
+                    Token t(TokenType::INT_LIT, src.substr(tokenStart, i - tokenStart), line); 
+                    if(from_chars(src.data() + tokenStart, src.data() + i, t.intVal).ec != errc()){
+                        if(!bigint){
+                            errs()<<"[LEXER ERROR] Line " << line << ": integer literal out of range '"<<t.text<<"'\n";
+                            fail();
+                        }
+                        t.big = true;
+                    }
+                    if(debug && t.big) cout << "[LEXER] Integer literal: " << t.text << " (big)" << endl;
+                    else if(debug) cout << "[LEXER] Integer literal: " << t.text << " (value: " << t.intVal << ")" << endl;
+                    return t; 
+                }
+                case CC_IDENT: {
+                    while(classAt(i)==CC_IDENT || classAt(i)==CC_DIGIT) i++;
+                    string_view s = src.substr(tokenStart, i - tokenStart);
+                    Token t(keywordType(s), s, line);
+                    if(debug){
+                        if(t.type==TokenType::IDENT) cout << "[LEXER] Identifier: " << s << endl;
+                        else cout << "[LEXER] Keyword: " << s << endl;
+                    }
+                    return t; 
+                }
+                case CC_SLASH:
+                    if(classAt(i + 1)==CC_SLASH){
+                        if(debug) cout << "[LEXER] Skipping comment" << endl;
+                        i += 2;
+                        skipComment();
+                        continue;
+                    }
+                    break;
+                case CC_CMP:
+                    if(classAt(i + 1)==CC_CMP && src[i + 1]=='='){
+                        Token t(lexTables.withEq[(unsigned char)src[i]], src.substr(i, 2), line);
+                        i += 2;
+                        if(debug) cout << "[LEXER] Operator: " << t.text << endl;
+                        return t;
+                    }
+                    break;
+                default:
+                    break;
+            }
             
-            char ch = get();
-            Token result(TokenType::END, "", line);
-            switch(ch){
-                case '+': result = Token(TokenType::PLUS, "+", line); break;
-                case '-': result = Token(TokenType::MINUS, "-", line); break;
-                case '*': result = Token(TokenType::MUL, "*", line); break;
-                case '/': result = Token(TokenType::DIV, "/", line); break;
-                case '%': result = Token(TokenType::MOD, "%", line); break;
-                case '=': result = Token(TokenType::ASSIGN, "=", line); break;
-                case '<': result = Token(TokenType::LT, "<", line); break;
-                case '>': result = Token(TokenType::GT, ">", line); break;
-                case '(' : result = Token(TokenType::LPAREN, "(", line); break;
-                case ')' : result = Token(TokenType::RPAREN, ")", line); break;
-                case '{' : result = Token(TokenType::LBRACE, "{", line); break;
-                case '}' : result = Token(TokenType::RBRACE, "}", line); break;
-                case ';' : result = Token(TokenType::SEMI, ";", line); break;
-                default: cerr<<"[LEXER ERROR] Line " << line << ": unexpected char '"<<ch<<"'\n"; exit(1);
-            }
-            if(debug && result.type != TokenType::END) {
-                cout << "[LEXER] Token: " << tokenTypeName(result.type) << " '" << result.text << "'" << endl;
+            char ch = src[i++];
+            Token result(lexTables.single[(unsigned char)ch], src.substr(tokenStart, 1), line);
+            if(result.type==TokenType::END){
+                errs()<<"[LEXER ERROR] Line " << line << ": unexpected char '"<<ch<<"'\n"; 
+                fail();
+            }
+            if(debug) cout << "[LEXER] Token: " << tokenTypeName(result.type) << " '" << result.text << "'" << endl;
+            return result;
+        }
+    }
+};
+
+// ============================================================================
+// PHASE 2: SYNTAX ANALYSIS - Abstract Syntax Tree Definitions
+// ============================================================================
+// Runtime environment: one value per resolved variable slot, plus a bitmap
+// recording which slots have been assigned so far.  --bigint runs hold Nums.
+template<class Value> struct BasicFrame {
+    vector<Value> slots;
+    vector<bool> init;
+    BasicFrame(size_t n=0): slots(n, 0), init(n, false) {}
+};
+typedef BasicFrame<long long> Frame;
+
+// Destination of every print statement, whichever engine runs it.  Values are
+// formatted with to_chars into a large buffer that goes out with write(2),
+// bypassing iostreams; binary mode writes raw little-endian int64s instead.
+// Flushing per line is for terminals and -d, where output must interleave
+// with diagnostics; the destructor flushes whatever is left, also on exit().
+// Each thread has its own sink; a --batch job sets `capture` to collect its
+// output in memory instead.
+struct PrintSink {
+    static constexpr size_t CAPACITY = 1 << 20;
+    unique_ptr<char[]> buf{new char[CAPACITY]};
+    size_t len = 0;
+    bool binary = false;
+    bool lineFlush = false;
+    string *capture = nullptr;
+#ifdef MINILANG_HAVE_POSIX
+    int fd = STDOUT_FILENO;     // the benchmark harness points this at /dev/null
+#endif
+
+    ~PrintSink(){ flush(); }
+
+    void put(long long v){
+        if(CAPACITY - len < 21) flush();    // "-9223372036854775808\n"
+        if(binary){
+            uint64_t u = v;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            memcpy(buf.get() + len, &u, 8);
+            len += 8;
+#else
+            for(int k = 0; k < 8; k++) buf[len++] = (char)(u >> (8 * k));
+#endif
+        } else {
+            len = to_chars(buf.get() + len, buf.get() + CAPACITY, v).ptr - buf.get();
+            buf[len++] = '\n';
+            if(lineFlush) flush();
+        }
+    }
+
+    // An already formatted value (a --bigint number beyond 64 bits).
+    void putText(string_view digits){
+        putBytes(digits);
+        if(len == CAPACITY) flush();
+        buf[len++] = '\n';
+        if(lineFlush) flush();
+    }
+
+    // Many values at once, with one capacity check per run that fits.
+    void putMany(const long long *v, size_t n){
+        if(binary || lineFlush){
+            for(size_t k = 0; k < n; k++) put(v[k]);
+            return;
+        }
+        while(n > 0){
+            size_t m = min(n, (CAPACITY - len) / 21);
+            if(m == 0){
+                flush();
+                continue;
+            }
+            char *p = buf.get() + len, *end = buf.get() + CAPACITY;
+            for(size_t k = 0; k < m; k++){
+                p = to_chars(p, end, v[k]).ptr;
+                *p++ = '\n';
+            }
+            len = p - buf.get();
+            v += m;
+            n -= m;
+        }
+    }
+
+    // Output another sink already formatted (a chunk of a parallel loop).
+    void putBytes(string_view bytes){
+        for(size_t k = 0; k < bytes.size(); ){
+            if(len == CAPACITY) flush();
+            size_t n = min(CAPACITY - len, bytes.size() - k);
+            memcpy(buf.get() + len, bytes.data() + k, n);
+            len += n;
+            k += n;
+        }
+    }
+
+    void flush(){
+        const char *p = buf.get();
+        if(capture){
+            capture->append(p, len);
+            len = 0;
+            return;
+        }
+#ifdef MINILANG_HAVE_POSIX
+        fflush(stdout);     // anything cout has queued goes first
+        while(len > 0){
+            ssize_t n = write(fd, p, len);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) break;
+            p += n;
+            len -= n;
+        }
+#else
+        cout.flush();
+        fwrite(p, 1, len, stdout);
+        fflush(stdout);
+#endif
+        len = 0;
+    }
+};
+static thread_local PrintSink programOut;
+
+// cerr is tied to this stream, so any diagnostic first pushes out the program
+// output buffered so far, just as it used to flush cout.
+struct PrintSinkTie : streambuf {
+    int sync() override { programOut.flush(); return 0; }
+};
+static PrintSinkTie programOutTieBuf;
+static ostream programOutTie(&programOutTieBuf);
+
+// Binary operators are decided once by the parser; nothing downstream
+// compares operator strings.
+enum class BinOp : uint8_t { ADD, SUB, MUL, DIV, MOD, EQ, NEQ, LT, GT, LTE, GTE };
+
+const char *binOpText(BinOp op){
+    static const char *text[] = { "+", "-", "*", "/", "%", "==", "!=", "<", ">", "<=", ">=" };
+    return text[static_cast<int>(op)];
+}
+
+BinOp binOpFor(TokenType t){
+    switch(t){
+        case TokenType::PLUS:  return BinOp::ADD;
+        case TokenType::MINUS: return BinOp::SUB;
+        case TokenType::MUL:   return BinOp::MUL;
+        case TokenType::DIV:   return BinOp::DIV;
+        case TokenType::MOD:   return BinOp::MOD;
+        case TokenType::EQ:    return BinOp::EQ;
+        case TokenType::NEQ:   return BinOp::NEQ;
+        case TokenType::LT:    return BinOp::LT;
+        case TokenType::GT:    return BinOp::GT;
+        case TokenType::LTE:   return BinOp::LTE;
+        case TokenType::GTE:   return BinOp::GTE;
+        default:
+            errs()<<"[PARSER ERROR] Token is not a binary operator\n";
+            fail();
+    }
+}
+
+// Applies O to two operands; division by zero is the caller's concern.
+template<BinOp O> inline long long applyBinOp(long long A, long long B){
+    if constexpr(O==BinOp::ADD) return A+B;
+    else if constexpr(O==BinOp::SUB) return A-B;
+    else if constexpr(O==BinOp::MUL) return A*B;
+    else if constexpr(O==BinOp::DIV) return A/B;
+    else if constexpr(O==BinOp::MOD) return A%B;
+    else if constexpr(O==BinOp::EQ) return A==B;
+    else if constexpr(O==BinOp::NEQ) return A!=B;
+    else if constexpr(O==BinOp::LT) return A<B;
+    else if constexpr(O==BinOp::GT) return A>B;
+    else if constexpr(O==BinOp::LTE) return A<=B;
+    else return A>=B;
+}
+
+// Runtime-selected variant used by the optimizer; returns false when the
+// operation cannot be folded (division or modulo by zero, or the one
+// quotient that overflows).  With `exact` (--bigint) any result that does not
+// fit in 64 bits is left to run time instead of wrapping.
+bool evalBinOp(BinOp op, long long A, long long B, long long &r, bool exact = false){
+    if((op==BinOp::DIV || op==BinOp::MOD) && A==LLONG_MIN && B==-1) return false;
+    if(exact){
+        if(op==BinOp::ADD) return !__builtin_add_overflow(A, B, &r);
+        if(op==BinOp::SUB) return !__builtin_sub_overflow(A, B, &r);
+        if(op==BinOp::MUL) return !__builtin_mul_overflow(A, B, &r);
+    }
+    switch(op){
+        case BinOp::ADD: r = applyBinOp<BinOp::ADD>(A,B); return true;
+        case BinOp::SUB: r = applyBinOp<BinOp::SUB>(A,B); return true;
+        case BinOp::MUL: r = applyBinOp<BinOp::MUL>(A,B); return true;
+        case BinOp::DIV: if(B==0) return false; r = applyBinOp<BinOp::DIV>(A,B); return true;
+        case BinOp::MOD: if(B==0) return false; r = applyBinOp<BinOp::MOD>(A,B); return true;
+        case BinOp::EQ:  r = applyBinOp<BinOp::EQ>(A,B); return true;
+        case BinOp::NEQ: r = applyBinOp<BinOp::NEQ>(A,B); return true;
+        case BinOp::LT:  r = applyBinOp<BinOp::LT>(A,B); return true;
+        case BinOp::GT:  r = applyBinOp<BinOp::GT>(A,B); return true;
+        case BinOp::LTE: r = applyBinOp<BinOp::LTE>(A,B); return true;
+        case BinOp::GTE: r = applyBinOp<BinOp::GTE>(A,B); return true;
+    }
+    return false;
+}
+
+// Division and modulo trap in hardware on a zero divisor and on
+// LLONG_MIN / -1; every engine reports both through here instead, so a
+// --batch job or --serve request fails on its own.
+[[noreturn]] __attribute__((cold)) void divisionFault(long long B){
+    if(B==0) errs()<<"[RUNTIME ERROR] Division by zero\n";
+    else errs()<<"[RUNTIME ERROR] Division overflow\n";
+    fail();
+}
+
+inline void checkDivisor(long long A, long long B){
+    if(B==0 || (B==-1 && A==LLONG_MIN)) divisionFault(B);
+}
+
+// Runtime variant shared by the TAC-level executors; faults are reported
+// exactly as AstInterpreter::binary does.
+long long runBinOp(BinOp op, long long A, long long B){
+    switch(op){
+        case BinOp::ADD: return applyBinOp<BinOp::ADD>(A,B);
+        case BinOp::SUB: return applyBinOp<BinOp::SUB>(A,B);
+        case BinOp::MUL: return applyBinOp<BinOp::MUL>(A,B);
+        case BinOp::DIV: checkDivisor(A,B); return applyBinOp<BinOp::DIV>(A,B);
+        case BinOp::MOD: checkDivisor(A,B); return applyBinOp<BinOp::MOD>(A,B);
+        case BinOp::EQ:  return applyBinOp<BinOp::EQ>(A,B);
+        case BinOp::NEQ: return applyBinOp<BinOp::NEQ>(A,B);
+        case BinOp::LT:  return applyBinOp<BinOp::LT>(A,B);
+        case BinOp::GT:  return applyBinOp<BinOp::GT>(A,B);
+        case BinOp::LTE: return applyBinOp<BinOp::LTE>(A,B);
+        case BinOp::GTE: return applyBinOp<BinOp::GTE>(A,B);
+    }
+    return 0;
+}
+
+// ============================================================================
+// ARBITRARY-PRECISION INTEGERS (--bigint)
+// ============================================================================
+// Magnitudes are little-endian arrays of 32-bit limbs.  The routines below
+// work on raw limb ranges and never allocate their result: callers size it.
+typedef uint32_t Limb;
+
+// Limb count without leading zero limbs.
+inline size_t limbsUsed(const Limb *a, size_t n){
+    while(n && !a[n - 1]) n--;
+    return n;
+}
+
+int compareLimbs(const Limb *a, size_t an, const Limb *b, size_t bn){
+    an = limbsUsed(a, an);
+    bn = limbsUsed(b, bn);
+    if(an != bn) return an < bn ? -1 : 1;
+    for(size_t k = an; k-- > 0; )
+        if(a[k] != b[k]) return a[k] < b[k] ? -1 : 1;
+    return 0;
+}
+
+// r[0..an) = a + b for an >= bn; returns the carry out.  r may alias a.
+Limb addLimbs(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn){
+    uint64_t c = 0;
+    size_t k = 0;
+    for(; k < bn; k++){ c += (uint64_t)a[k] + b[k]; r[k] = (Limb)c; c >>= 32; }
+    for(; k < an; k++){ c += a[k]; r[k] = (Limb)c; c >>= 32; }
+    return (Limb)c;
+}
+
+// r[0..an) = a - b for a >= b and an >= bn.  r may alias a.
+void subLimbs(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn){
+    int64_t c = 0;
+    size_t k = 0;
+    for(; k < bn; k++){ c += (int64_t)a[k] - b[k]; r[k] = (Limb)c; c >>= 32; }
+    for(; k < an; k++){ c += a[k]; r[k] = (Limb)c; c >>= 32; }
+}
+
+// r[0..an+bn) = a * b, schoolbook.
+void mulSchool(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn){
+    fill(r, r + an + bn, 0);
+    for(size_t i = 0; i < an; i++){
+        uint64_t c = 0, ai = a[i];
+        if(!ai) continue;
+        for(size_t j = 0; j < bn; j++){
+            c += ai * b[j] + r[i + j];
+            r[i + j] = (Limb)c;
+            c >>= 32;
+        }
+        r[i + bn] = (Limb)c;
+    }
+}
+
+// Below this many limbs in the shorter operand schoolbook is faster.
+static constexpr size_t KARATSUBA_LIMBS = 32;
+
+// r[0..an+bn) = a * b.  Karatsuba splits both operands at h limbs and needs
+// three half-size products, (a0+a1)(b0+b1) - a0*b0 - a1*b1 giving the
+// middle term; an operand more than twice as long as the other is cut into
+// slices the length of the shorter one first.
+void mulLimbs(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn){
+    if(an < bn){
+        swap(a, b);
+        swap(an, bn);
+    }
+    if(bn < KARATSUBA_LIMBS){
+        mulSchool(r, a, an, b, bn);
+        return;
+    }
+    if(an >= 2 * bn){
+        fill(r, r + an + bn, 0);
+        vector<Limb> part(2 * bn);
+        for(size_t i = 0; i < an; i += bn){
+            size_t k = min(bn, an - i);
+            mulLimbs(part.data(), a + i, k, b, bn);
+            addLimbs(r + i, r + i, an + bn - i, part.data(), k + bn);
+        }
+        return;
+    }
+    size_t h = (an + 1) / 2;            // bn > an/2, so b has at least h limbs
+    vector<Limb> tmp(4 * h + 4);
+    Limb *sa = tmp.data(), *sb = sa + h + 1, *mid = sb + h + 1;
+    mulLimbs(r, a, h, b, h);                            // a0*b0 in r[0..2h)
+    mulLimbs(r + 2 * h, a + h, an - h, b + h, bn - h);  // a1*b1 in r[2h..an+bn)
+    sa[h] = addLimbs(sa, a, h, a + h, an - h);
+    sb[h] = addLimbs(sb, b, h, b + h, bn - h);
+    mulLimbs(mid, sa, h + 1, sb, h + 1);
+    subLimbs(mid, mid, 2 * h + 2, r, 2 * h);
+    subLimbs(mid, mid, 2 * h + 2, r + 2 * h, an + bn - 2 * h);
+    addLimbs(r + h, r + h, an + bn - h, mid, limbsUsed(mid, 2 * h + 2));
+}
+
+// q[0..m-n] = u / v and rem[0..n) = u % v for m >= n and v[n-1] != 0
+// (Knuth's algorithm D, as in Hacker's Delight).
+void divLimbs(Limb *q, Limb *rem, const Limb *u, size_t m, const Limb *v, size_t n){
+    const uint64_t B = 1ull << 32;
+    if(n == 1){
+        uint64_t k = 0;
+        for(size_t j = m; j-- > 0; ){
+            uint64_t cur = k << 32 | u[j];
+            q[j] = (Limb)(cur / v[0]);
+            k = cur % v[0];
+        }
+        rem[0] = (Limb)k;
+        return;
+    }
+    // Normalize so that the divisor's top bit is set.
+    int s = __builtin_clz(v[n - 1]);
+    auto shifted = [s](Limb hi, Limb lo){ return (Limb)(((uint64_t)hi << 32 | lo) >> (32 - s)); };
+    vector<Limb> vn(n), un(m + 1);
+    for(size_t i = n - 1; i > 0; i--) vn[i] = shifted(v[i], v[i - 1]);
+    vn[0] = v[0] << s;
+    un[m] = shifted(0, u[m - 1]);
+    for(size_t i = m - 1; i > 0; i--) un[i] = shifted(u[i], u[i - 1]);
+    un[0] = u[0] << s;
+    for(size_t j = m - n + 1; j-- > 0; ){
+        uint64_t num = (uint64_t)un[j + n] << 32 | un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+        while(qhat >= B || qhat * vn[n - 2] > (rhat << 32 | un[j + n - 2])){
+            qhat--;
+            rhat += vn[n - 1];
+            if(rhat >= B) break;
+        }
+        int64_t k = 0, t;
+        for(size_t i = 0; i < n; i++){
+            uint64_t p = qhat * vn[i];
+            t = un[i + j] - k - (int64_t)(p & 0xFFFFFFFF);
+            un[i + j] = (Limb)t;
+            k = (int64_t)(p >> 32) - (t >> 32);
+        }
+        t = un[j + n] - k;
+        un[j + n] = (Limb)t;
+        q[j] = (Limb)qhat;
+        if(t < 0){                      // qhat was one too large: add v back
+            q[j]--;
+            uint64_t c = 0;
+            for(size_t i = 0; i < n; i++){
+                c += (uint64_t)un[i + j] + vn[i];
+                un[i + j] = (Limb)c;
+                c >>= 32;
+            }
+            un[j + n] += (Limb)c;
+        }
+    }
+    for(size_t i = 0; i < n; i++) rem[i] = (Limb)(((uint64_t)un[i + 1] << 32 | un[i]) >> s);
+}
+
+// A heap integer: sign and magnitude, never changed once built, so values
+// share it freely.  The limbs follow the header in the same block.
+struct BigInt {
+    uint32_t size;             // limbs in use; the top one is nonzero
+    uint8_t sizeClass;         // capacity is 1 << sizeClass limbs
+    bool negative;
+    bool marked;               // reachable at the last LimbPool::sweep
+    Limb *limbs(){ return reinterpret_cast<Limb*>(this + 1); }
+    size_t bytes() const { return sizeof(BigInt) + (sizeof(Limb) << sizeClass); }
+};
+
+// Per-thread BigInt storage: free lists of blocks, one per power-of-two
+// capacity, so that a loop producing values of similar size recycles a few
+// blocks instead of going to malloc for each.  Nums carry no reference
+// count (which keeps them a plain word, passed in registers); instead the
+// interpreter marks the values it holds between statements and sweep()
+// recycles every other block once `limit` bytes are in use.
+struct LimbPool {
+    static constexpr int CLASSES = 40, KEEP = 64;      // free blocks kept per class
+    static constexpr size_t MIN_LIMIT = 1 << 20;
+    vector<BigInt*> free[CLASSES];
+    vector<BigInt*> live;      // every block handed out and not yet swept
+    size_t bytes = 0, limit = MIN_LIMIT;
+
+    ~LimbPool(){
+        for(BigInt *b : live) ::operator delete(b);
+        for(auto &list : free)
+            for(BigInt *b : list) ::operator delete(b);
+    }
+
+    BigInt *get(size_t limbs){
+        int c = 2;
+        while(((size_t)1 << c) < limbs) c++;
+        BigInt *b;
+        if(!free[c].empty()){
+            b = free[c].back();
+            free[c].pop_back();
+        } else b = static_cast<BigInt*>(::operator new(sizeof(BigInt) + (sizeof(Limb) << c)));
+        b->size = 0;
+        b->sizeClass = c;
+        b->negative = b->marked = false;
+        live.push_back(b);
+        bytes += b->bytes();
+        return b;
+    }
+
+    void recycle(BigInt *b){
+        if(free[b->sizeClass].size() < KEEP) free[b->sizeClass].push_back(b);
+        else ::operator delete(b);
+    }
+
+    // Returns a block that never became visible, one of the last few taken.
+    void put(BigInt *b){
+        for(size_t k = live.size(); k-- > 0; )
+            if(live[k] == b){
+                live[k] = live.back();
+                live.pop_back();
+                break;
+            }
+        bytes -= b->bytes();
+        recycle(b);
+    }
+
+    bool due() const { return bytes > limit; }
+
+    // Recycles every block not marked since the last sweep.
+    void sweep(){
+        size_t kept = 0;
+        bytes = 0;
+        for(BigInt *b : live){
+            if(!b->marked){
+                recycle(b);
+                continue;
+            }
+            b->marked = false;
+            bytes += b->bytes();
+            live[kept++] = b;
+        }
+        live.resize(kept);
+        limit = max(MIN_LIMIT, 2 * bytes);
+    }
+};
+static thread_local LimbPool limbPool;
+
+// The --bigint value type.  Integers in [-2^62, 2^62) live inline as the
+// tagged word 2v+1, so that arithmetic on them is one overflow-checked
+// machine instruction; a result that overflows the 63 bits is promoted to a
+// BigInt (whose pointer is even), and a BigInt result that fits again is
+// demoted, so every value has exactly one representation.
+struct Num {
+    static constexpr long long SMALL_MIN = -(1LL << 62), SMALL_MAX = (1LL << 62) - 1;
+    uintptr_t bits = 1;
+
+    Num() = default;
+    Num(long long v){
+        if(v >= SMALL_MIN && v <= SMALL_MAX) bits = (uintptr_t)v << 1 | 1;
+        else {
+            uint64_t u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+            BigInt *b = limbPool.get(2);
+            b->limbs()[0] = (Limb)u;
+            b->limbs()[1] = (Limb)(u >> 32);
+            b->size = 2;
+            b->negative = v < 0;
+            bits = (uintptr_t)b;
+        }
+    }
+
+    static Num tagged(uintptr_t t){ Num n; n.bits = t; return n; }
+    bool isSmall() const { return bits & 1; }
+    long long small() const { return (long long)bits >> 1; }
+    BigInt *big() const { return reinterpret_cast<BigInt*>(bits); }
+    bool isZero() const { return bits == 1; }
+    explicit operator bool() const { return bits != 1; }
+    void mark() const { if(!isSmall()) big()->marked = true; }
+
+    // Takes over b, holding n limbs of magnitude, as the value's result.
+    static Num finish(BigInt *b, size_t n, bool negative){
+        n = limbsUsed(b->limbs(), n);
+        if(n <= 2){
+            uint64_t u = n == 0 ? 0 : n == 1 ? b->limbs()[0] : (uint64_t)b->limbs()[1] << 32 | b->limbs()[0];
+            if(u <= (uint64_t)SMALL_MAX || (negative && u == (uint64_t)SMALL_MAX + 1)){
+                limbPool.put(b);
+                return Num(negative ? (long long)(0 - u) : (long long)u);
+            }
+        }
+        b->size = n;
+        b->negative = negative;
+        return tagged((uintptr_t)b);
+    }
+
+    // Decimal digits only; the sign comes from the parser as 0 - x.
+    static Num parse(string_view digits){
+        vector<Limb> mag;
+        for(size_t k = 0; k < digits.size(); ){
+            size_t len = min<size_t>(9, digits.size() - k);
+            uint64_t chunk = 0, scale = 1;
+            for(size_t e = 0; e < len; e++, k++){
+                chunk = chunk * 10 + (digits[k] - '0');
+                scale *= 10;
+            }
+            for(Limb &l : mag){
+                chunk += l * scale;
+                l = (Limb)chunk;
+                chunk >>= 32;
+            }
+            if(chunk) mag.push_back((Limb)chunk);
+        }
+        BigInt *b = limbPool.get(max<size_t>(mag.size(), 1));
+        copy(mag.begin(), mag.end(), b->limbs());
+        return finish(b, mag.size(), false);
+    }
+
+    string toString() const {
+        if(isSmall()) return to_string(small());
+        vector<Limb> mag(big()->limbs(), big()->limbs() + big()->size);
+        vector<Limb> chunks;            // base 10^9, least significant first
+        const Limb billion = 1000000000;
+        while(!mag.empty()){
+            Limb r;
+            divLimbs(mag.data(), &r, mag.data(), mag.size(), &billion, 1);
+            chunks.push_back(r);
+            mag.resize(limbsUsed(mag.data(), mag.size()));
+        }
+        string s = big()->negative ? "-" : "";
+        s += to_string(chunks.back());
+        for(size_t k = chunks.size() - 1; k-- > 0; ){
+            string part = to_string(chunks[k]);
+            s.append(9 - part.size(), '0');
+            s += part;
+        }
+        return s;
+    }
+};
+
+static_assert(is_trivially_copyable_v<Num>, "Num must stay a plain word");
+
+// Sign and magnitude of a Num, whether inline or on the heap.
+struct NumDigits {
+    const Limb *d;
+    size_t n;
+    bool negative;
+    Limb own[2];
+
+    NumDigits(const Num &x){
+        if(x.isSmall()){
+            long long v = x.small();
+            uint64_t u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+            own[0] = (Limb)u;
+            own[1] = (Limb)(u >> 32);
+            d = own;
+            n = limbsUsed(own, 2);
+            negative = v < 0;
+        } else {
+            d = x.big()->limbs();
+            n = x.big()->size;
+            negative = x.big()->negative;
+        }
+    }
+    NumDigits(const NumDigits&) = delete;
+};
+
+// a + b, where b's sign is given separately so that subtraction is a + (-b).
+Num addNum(const NumDigits &a, const NumDigits &b, bool bNegative){
+    const NumDigits *x = &a, *y = &b;
+    bool xNeg = a.negative, yNeg = bNegative;
+    if(a.n < b.n){
+        swap(x, y);
+        swap(xNeg, yNeg);
+    }
+    if(xNeg == yNeg){
+        BigInt *r = limbPool.get(x->n + 1);
+        r->limbs()[x->n] = addLimbs(r->limbs(), x->d, x->n, y->d, y->n);
+        return Num::finish(r, x->n + 1, xNeg);
+    }
+    int c = compareLimbs(x->d, x->n, y->d, y->n);
+    if(c == 0) return Num();
+    if(c < 0){
+        swap(x, y);
+        swap(xNeg, yNeg);
+    }
+    BigInt *r = limbPool.get(x->n);
+    subLimbs(r->limbs(), x->d, x->n, y->d, y->n);
+    return Num::finish(r, x->n, xNeg);
+}
+
+int compareNum(const NumDigits &a, const NumDigits &b){
+    if(a.negative != b.negative) return a.negative ? -1 : 1;
+    int c = compareLimbs(a.d, a.n, b.d, b.n);
+    return a.negative ? -c : c;
+}
+
+// The general case of applyBinOp on Nums: at least one operand is on the
+// heap, or the inline operation overflowed.  Division truncates toward
+// zero and the remainder takes the dividend's sign, as for long long.
+__attribute__((noinline)) Num bigBinOp(BinOp op, const Num &A, const Num &B){
+    NumDigits a(A), b(B);
+    switch(op){
+        case BinOp::ADD: return addNum(a, b, b.negative);
+        case BinOp::SUB: return addNum(a, b, !b.negative && b.n);
+        case BinOp::MUL: {
+            if(!a.n || !b.n) return Num();
+            BigInt *r = limbPool.get(a.n + b.n);
+            mulLimbs(r->limbs(), a.d, a.n, b.d, b.n);
+            return Num::finish(r, a.n + b.n, a.negative != b.negative);
+        }
+        case BinOp::DIV: case BinOp::MOD: {
+            if(compareLimbs(a.d, a.n, b.d, b.n) < 0) return op == BinOp::DIV ? Num() : A;
+            BigInt *q = limbPool.get(a.n - b.n + 1), *r = limbPool.get(b.n);
+            divLimbs(q->limbs(), r->limbs(), a.d, a.n, b.d, b.n);
+            if(op == BinOp::DIV){
+                limbPool.put(r);
+                return Num::finish(q, a.n - b.n + 1, a.negative != b.negative);
+            }
+            limbPool.put(q);
+            return Num::finish(r, b.n, a.negative);
+        }
+        case BinOp::EQ:  return compareNum(a, b) == 0;
+        case BinOp::NEQ: return compareNum(a, b) != 0;
+        case BinOp::LT:  return compareNum(a, b) < 0;
+        case BinOp::GT:  return compareNum(a, b) > 0;
+        case BinOp::LTE: return compareNum(a, b) <= 0;
+        case BinOp::GTE: return compareNum(a, b) >= 0;
+    }
+    return Num();
+}
+
+// applyBinOp for --bigint: inline operands take the machine-word path, with
+// the tags folded into the operation (2a+1 + 2b+1 - 1 = 2(a+b)+1), and fall
+// back to bigBinOp only when the 63-bit result overflows.
+template<BinOp O> inline Num applyBinOp(const Num &A, const Num &B){
+    if(A.isSmall() && B.isSmall()){
+        long long a = (long long)A.bits, b = (long long)B.bits, r;
+        if constexpr(O==BinOp::ADD){ if(!__builtin_add_overflow(a, b - 1, &r)) return Num::tagged(r); }
+        else if constexpr(O==BinOp::SUB){ if(!__builtin_sub_overflow(a, b - 1, &r)) return Num::tagged(r); }
+        else if constexpr(O==BinOp::MUL){ if(!__builtin_mul_overflow(A.small(), b - 1, &r)) return Num::tagged(r + 1); }
+        else if constexpr(O==BinOp::DIV) return Num(A.small() / B.small());     // -2^62 / -1 is promoted
+        else if constexpr(O==BinOp::MOD) return Num::tagged((uintptr_t)(A.small() % B.small()) << 1 | 1);
+        else return Num::tagged(applyBinOp<O>(a, b) << 1 | 1);     // the tags preserve order
+    }
+    return bigBinOp(O, A, B);
+}
+
+inline bool isZero(long long v){ return v == 0; }
+inline bool isZero(const Num &v){ return v.isZero(); }
+
+Num runBinOp(BinOp op, const Num &A, const Num &B){
+    switch(op){
+        case BinOp::ADD: return applyBinOp<BinOp::ADD>(A,B);
+        case BinOp::SUB: return applyBinOp<BinOp::SUB>(A,B);
+        case BinOp::MUL: return applyBinOp<BinOp::MUL>(A,B);
+        case BinOp::DIV: case BinOp::MOD:
+            if(B.isZero()){
+                errs()<<"[RUNTIME ERROR] Division by zero\n";
+                fail();
+            }
+            return op == BinOp::DIV ? applyBinOp<BinOp::DIV>(A,B) : applyBinOp<BinOp::MOD>(A,B);
+        case BinOp::EQ:  return applyBinOp<BinOp::EQ>(A,B);
+        case BinOp::NEQ: return applyBinOp<BinOp::NEQ>(A,B);
+        case BinOp::LT:  return applyBinOp<BinOp::LT>(A,B);
+        case BinOp::GT:  return applyBinOp<BinOp::GT>(A,B);
+        case BinOp::LTE: return applyBinOp<BinOp::LTE>(A,B);
+        case BinOp::GTE: return applyBinOp<BinOp::GTE>(A,B);
+    }
+    return Num();
+}
+
+// Interned identifiers: every distinct name gets a dense id the first time
+// the parser sees it, and that id doubles as the variable's frame slot.
+// Lookups hash the token's slice directly (open addressing over slot ids),
+// so only a name's first occurrence allocates.
+struct SlotTable {
+    vector<string> names;
+    vector<int> buckets;       // slot + 1, or 0 when empty; size is a power of two
+
+    int resolve(string_view name){
+        if(2 * (names.size() + 1) > buckets.size()) rehash(max<size_t>(64, 2 * buckets.size()));
+        size_t mask = buckets.size() - 1;
+        for(size_t h = hash<string_view>()(name) & mask; ; h = (h + 1) & mask){
+            if(!buckets[h]){
+                names.emplace_back(name);
+                buckets[h] = names.size();
+                return names.size() - 1;
+            }
+            if(names[buckets[h] - 1] == name) return buckets[h] - 1;
+        }
+    }
+    void rehash(size_t n){
+        buckets.assign(n, 0);
+        for(size_t slot = 0; slot < names.size(); slot++){
+            size_t h = hash<string_view>()(names[slot]) & (n - 1);
+            while(buckets[h]) h = (h + 1) & (n - 1);
+            buckets[h] = slot + 1;
+        }
+    }
+    size_t size() const { return names.size(); }
+};
+
+// Node kinds; ADD..GTE mirror BinOp, so a binary node's kind is its operator.
+enum class NodeKind : uint8_t {
+    ADD, SUB, MUL, DIV, MOD, EQ, NEQ, LT, GT, LTE, GTE,
+    INT,       // literal: value split over a (low) and b (high)
+    BIGLIT,    // --bigint literal beyond 64 bits: a = index into Ast::bigLits
+    VAR,       // a = slot
+    PRINT,     // a = expression
+    ASSIGN,    // a = slot, b = expression
+    BLOCK,     // statements are Ast::lists[a .. a+b)
+    IF,        // a = condition, b = then block, c = else block or NO_NODE
+    WHILE,     // a = condition, b = body block
+};
+
+static_assert(static_cast<int>(NodeKind::GTE) == static_cast<int>(BinOp::GTE), "NodeKind must mirror BinOp");
+
+typedef uint32_t NodeId;
+static const NodeId NO_NODE = UINT32_MAX;
+
+// 16 bytes, no owned memory: children are indices into the same array.
+// Statements keep their source line in the padding after `kind`.
+struct Node {
+    NodeKind kind;
+    uint32_t line : 24;     // statements only; saturates at MAX_LINE
+    uint32_t a = 0, b = 0, c = NO_NODE;
+
+    static constexpr uint32_t MAX_LINE = (1u << 24) - 1;
+
+    bool isBinary() const { return kind <= NodeKind::GTE; }
+    bool isLeaf() const { return kind==NodeKind::INT || kind==NodeKind::BIGLIT || kind==NodeKind::VAR; }
+    BinOp op() const { return static_cast<BinOp>(kind); }
+    long long value() const { return (long long)((uint64_t)b << 32 | a); }
+};
+
+static_assert(sizeof(Node) == 16, "Node must stay 16 bytes");
+
+// The whole program as one contiguous node array.  The parser appends
+// children before their parent (post-order), so the root comes last and the
+// tree is released with a single deallocation.
+struct Ast {
+    vector<Node> nodes;
+    vector<NodeId> lists;      // statement lists of BLOCK nodes
+    SlotTable names;
+    vector<Num> bigLits;
+    NodeId root = NO_NODE;
+
+    NodeId add(NodeKind k, uint32_t a = 0, uint32_t b = 0, uint32_t c = NO_NODE){
+        nodes.push_back({k, 0, a, b, c});
+        return nodes.size() - 1;
+    }
+    NodeId stmt(NodeKind k, int line, uint32_t a = 0, uint32_t b = 0, uint32_t c = NO_NODE){
+        NodeId id = add(k, a, b, c);
+        nodes[id].line = min<uint32_t>(line, Node::MAX_LINE);
+        return id;
+    }
+    NodeId intLit(long long v){ return add(NodeKind::INT, (uint32_t)(uint64_t)v, (uint32_t)((uint64_t)v >> 32)); }
+    NodeId bigLit(string_view digits){
+        bigLits.push_back(Num::parse(digits));
+        return add(NodeKind::BIGLIT, bigLits.size() - 1);
+    }
+    const Node &operator[](NodeId id) const { return nodes[id]; }
+    Node &operator[](NodeId id){ return nodes[id]; }
+    const NodeId *stmts(NodeId blk) const { return lists.data() + nodes[blk].a; }
+    const string &name(NodeId id) const { return names.names[nodes[id].a]; }
+    // Drops every node but keeps the interned names (and so the slots).
+    void clearNodes(){ nodes.clear(); lists.clear(); bigLits.clear(); root = NO_NODE; }
+
+    // No pass recurses on the C++ stack, however deeply the program nests:
+    // walks keep their own stack of node ids, tagged with VISITED once the
+    // node's children have been pushed.  Callers pass the stack in so that
+    // repeated walks reuse its storage.
+    static constexpr NodeId VISITED = 1u << 31;
+
+    // Calls f(id) for every node under root, children before their parent
+    // and siblings left to right (the order the parser created them in).
+    template<class F> void postOrder(NodeId root, vector<NodeId> &stack, F f) const {
+        size_t base = stack.size();
+        stack.push_back(root);
+        while(stack.size() > base){
+            NodeId id = stack.back();
+            stack.pop_back();
+            if(id & VISITED){
+                f(id & ~VISITED);
+                continue;
+            }
+            const Node &n = nodes[id];
+            if(n.isLeaf()){
+                f(id);
+                continue;
+            }
+            stack.push_back(id | VISITED);
+            switch(n.kind){
+                case NodeKind::PRINT:  stack.push_back(n.a); break;
+                case NodeKind::ASSIGN: stack.push_back(n.b); break;
+                case NodeKind::BLOCK:
+                    for(uint32_t k = n.b; k-- > 0; ) stack.push_back(stmts(id)[k]);
+                    break;
+                case NodeKind::IF:
+                    if(n.c != NO_NODE) stack.push_back(n.c);
+                    stack.push_back(n.b);
+                    stack.push_back(n.a);
+                    break;
+                default:               // WHILE and the binary operators
+                    stack.push_back(n.b);
+                    stack.push_back(n.a);
+                    break;
+            }
+        }
+    }
+
+    string toString(NodeId root) const {
+        vector<NodeId> stack;
+        vector<string> done;       // rendered children, leftmost first
+        postOrder(root, stack, [&](NodeId id){
+            const Node &n = nodes[id];
+            auto take = [&](size_t count){ return done.end() - count; };
+            string r;
+            switch(n.kind){
+                case NodeKind::INT:    r = "IntLit(" + to_string(n.value()) + ")"; break;
+                case NodeKind::BIGLIT: r = "IntLit(" + bigLits[n.a].toString() + ")"; break;
+                case NodeKind::VAR:    r = "VarExpr(" + name(id) + ")"; break;
+                case NodeKind::PRINT:  r = "PrintStmt(" + done.back() + ")"; done.pop_back(); break;
+                case NodeKind::ASSIGN: r = "AssignStmt(" + name(id) + ", " + done.back() + ")"; done.pop_back(); break;
+                case NodeKind::BLOCK: {
+                    r = "BlockStmt[\n";
+                    for(auto it = take(n.b); it != done.end(); ++it) r += "  " + *it + "\n";
+                    r += "]";
+                    done.erase(take(n.b), done.end());
+                    break;
+                }
+                case NodeKind::IF: {
+                    size_t count = n.c != NO_NODE ? 3 : 2;
+                    auto it = take(count);
+                    r = "IfStmt(" + it[0] + ",\n  THEN: " + it[1];
+                    if(count == 3) r += ",\n  ELSE: " + it[2];
+                    r += ")";
+                    done.erase(it, done.end());
+                    break;
+                }
+                case NodeKind::WHILE:
+                    r = "WhileStmt(" + take(2)[0] + ", " + take(2)[1] + ")";
+                    done.erase(take(2), done.end());
+                    break;
+                default:
+                    r = string("Binary(") + binOpText(n.op()) + ", " + take(2)[0] + ", " + take(2)[1] + ")";
+                    done.erase(take(2), done.end());
+                    break;
+            }
+            done.push_back(move(r));
+        });
+        return done.back();
+    }
+};
+
+// ============================================================================
+// PROFILING (--profile)
+// ============================================================================
+// Every operator new in the process goes through here, so a phase's
+// allocation count is the difference of the counter around it.  The counter
+// is per thread, which keeps --batch jobs from racing on it.
+static thread_local size_t allocationCount = 0;
+
+// GCC pairs the inlined malloc with a sized delete and warns spuriously.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void *operator new(size_t n){
+    allocationCount++;
+    if(void *p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+void *operator new[](size_t n){ return operator new(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+const char *stmtKindName(NodeKind k){
+    switch(k){
+        case NodeKind::PRINT:  return "PrintStmt";
+        case NodeKind::ASSIGN: return "AssignStmt";
+        case NodeKind::IF:     return "IfStmt";
+        case NodeKind::WHILE:  return "WhileStmt";
+        default:               return "Expr";
+    }
+}
+
+// Wall time and allocations per phase of runSource, and for every statement
+// node the number of times it ran and its inclusive time.  Only an
+// AstInterpreter<true> fills in the statement counters.
+struct Profiler {
+    struct Phase { const char *name; double ms; size_t allocations; };
+    vector<Phase> phases;
+    chrono::steady_clock::time_point phaseStart;
+    size_t phaseAllocs = 0;
+    vector<uint64_t> runs, nanos;       // indexed by NodeId
+
+    Profiler(){ phases.reserve(16); }
+
+    // Ends the running phase and starts `name` (nullptr: start nothing).
+    void phase(const char *name){
+        auto now = chrono::steady_clock::now();
+        if(!phases.empty() && phases.back().ms < 0){
+            phases.back().ms = chrono::duration<double, milli>(now - phaseStart).count();
+            phases.back().allocations = allocationCount - phaseAllocs;
+        }
+        if(!name) return;
+        phases.push_back({name, -1, 0});
+        phaseAllocs = allocationCount;
+        phaseStart = chrono::steady_clock::now();
+    }
+
+    void attach(const Ast &ast){
+        runs.assign(ast.nodes.size(), 0);
+        nanos.assign(ast.nodes.size(), 0);
+    }
+
+    // Sorted table on `out`; with a path, the same data as JSON there too.
+    void report(const Ast &ast, ostream &out, const string &jsonPath){
+        phase(nullptr);
+        struct Row { uint32_t line; NodeKind kind; uint64_t count, ns; };
+        vector<Row> rows;
+        if(!runs.empty()){
+            map<pair<uint32_t, NodeKind>, size_t> at;   // statements sharing a line and kind are merged
+            for(NodeId id = 0; id < ast.nodes.size(); id++){
+                const Node &n = ast[id];
+                if(n.kind != NodeKind::PRINT && n.kind != NodeKind::ASSIGN && n.kind != NodeKind::IF && n.kind != NodeKind::WHILE) continue;
+                auto [it, fresh] = at.emplace(make_pair((uint32_t)n.line, n.kind), rows.size());
+                if(fresh) rows.push_back({n.line, n.kind, 0, 0});
+                rows[it->second].count += runs[id];
+                rows[it->second].ns += nanos[id];
+            }
+            sort(rows.begin(), rows.end(), [](const Row &x, const Row &y){
+                return x.ns != y.ns ? x.ns > y.ns : x.line < y.line;
+            });
+        }
+        double total = 0, execMs = 0;
+        for(const Phase &ph : phases){
+            total += ph.ms;
+            if(string(ph.name) == "execute") execMs = ph.ms;
+        }
+
+        out << "\n=== PROFILE ===" << endl << fixed << setprecision(3);
+        out << left << setw(12) << "Phase" << right << setw(14) << "Wall ms" << setw(14) << "Allocations" << endl;
+        for(const Phase &ph : phases)
+            out << left << setw(12) << ph.name << right << setw(14) << ph.ms << setw(14) << ph.allocations << endl;
+        out << left << setw(12) << "total" << right << setw(14) << total << endl;
+        const size_t shown = 20;
+        if(runs.empty()){
+            out << "(statement counters need the AST interpreter: run without --vm, --jit or --count)" << endl;
+        } else {
+            out << "\n" << left << setw(12) << "Statement" << right << setw(8) << "Line" << setw(14) << "Count"
+                << setw(14) << "Total ms" << setw(9) << "% exec" << endl;
+            for(size_t k = 0; k < rows.size() && k < shown; k++)
+                out << left << setw(12) << stmtKindName(rows[k].kind) << right << setw(8) << rows[k].line
+                    << setw(14) << rows[k].count << setw(14) << rows[k].ns / 1e6
+                    << setw(8) << setprecision(1) << (execMs > 0 ? rows[k].ns / 1e4 / execMs : 0) << "%" << setprecision(3) << endl;
+            if(rows.size() > shown)
+                out << "(" << rows.size() - shown << " more statement lines" << (jsonPath.empty() ? "; see --profile-json)" : " in the JSON dump)") << endl;
+        }
+        out << defaultfloat << left;
+
+        if(jsonPath.empty()) return;
+        ofstream json(jsonPath);
+        if(!json){
+            cerr<<"[PROFILE ERROR] Cannot write "<<jsonPath<<"\n";
+            return;
+        }
+        json << fixed << setprecision(3) << "{\n  \"phases\": [\n";
+        for(size_t k = 0; k < phases.size(); k++)
+            json << "    {\"phase\": \"" << phases[k].name << "\", \"wall_ms\": " << phases[k].ms
+                 << ", \"allocations\": " << phases[k].allocations << "}" << (k + 1 < phases.size() ? "," : "") << "\n";
+        json << "  ],\n  \"statements\": [\n";
+        for(size_t k = 0; k < rows.size(); k++)
+            json << "    {\"line\": " << rows[k].line << ", \"statement\": \"" << stmtKindName(rows[k].kind)
+                 << "\", \"count\": " << rows[k].count << ", \"total_ms\": " << rows[k].ns / 1e6 << "}"
+                 << (k + 1 < rows.size() ? "," : "") << "\n";
+        json << "  ]\n}\n";
+        out << "[PROFILE] Wrote " << jsonPath << endl;
+    }
+};
+
+// ============================================================================
+// PARALLEL AND VECTORIZED LOOPS
+// ============================================================================
+// A counted loop `while (i < n) { ...; i = i + c; }` can run its iterations
+// on several threads when no iteration reads what another one wrote.  The
+// analysis accepts a while when:
+//   - its condition compares a variable i with <, <=, > or >= against an
+//     expression of variables the loop never assigns;
+//   - its body ends with i = i + c (or i - c), c a constant stepping towards
+//     the bound, and assigns i nowhere else;
+//   - every other variable the body assigns is assigned by a statement of the
+//     body itself (not only inside an if or while), and every read of such a
+//     variable comes after an assignment in the same iteration;
+//   - it cannot raise a runtime error: every divisor is a literal other than
+//     0 and -1, and the invariants and i are checked for definedness on entry.
+// Such a loop runs the same iterations with the same values in any order; the
+// only observable order is that of its prints, which each chunk of
+// iterations buffers for the ordered merge.  Variables the body assigns end
+// up with the values of the last iteration, as they would sequentially.
+//
+// When the body is straight-line (assignments and prints only), it is also
+// compiled to a LaneProgram and run over batches of iterations at once, one
+// iteration per 64-bit lane.  Such a loop may divide by anything: a batch in
+// which some lane would divide by zero or overflow runs on the interpreter
+// instead, so the error comes after the same output.  Vectorized loops run
+// even on one thread; parallel ones run their chunks vectorized.
+
+// A straight-line loop body as operations over lanes.  Register 0 holds i;
+// `setup` fills the registers of literals (INT, value in a/b as in Node) and
+// invariants (VAR, slot a) once per loop, and `ops` compute the other
+// registers for each batch.
+struct LaneOp {
+    NodeKind kind;
+    uint32_t dst, a, b;
+    uint8_t shift = 0;      // DIV or MOD by the literal 2^shift
+};
+
+struct LaneProgram {
+    vector<LaneOp> setup, ops;
+    vector<uint32_t> prints;                    // registers printed per iteration, in order
+    vector<pair<uint32_t, uint32_t>> finals;    // slot, register of its value at the end
+    uint32_t regs = 1;
+};
+
+// Lane kernels: d[k] = a[k] op b[k] for the first n lanes; the SIMD ones
+// round n up to whole vectors, which lane buffers leave room for.  Division
+// and modulo go lane by lane and, when a lane would divide by zero or
+// overflow, return false without computing anything.
+typedef bool (*LaneKernel)(long long *d, const long long *a, const long long *b, size_t n);
+
+template<BinOp O> bool laneKernel(long long *d, const long long *a, const long long *b, size_t n){
+    if constexpr(O == BinOp::DIV || O == BinOp::MOD){
+        for(size_t k = 0; k < n; k++)
+            if(b[k] == 0 || (a[k] == LLONG_MIN && b[k] == -1)) return false;
+    }
+    for(size_t k = 0; k < n; k++) d[k] = applyBinOp<O>(a[k], b[k]);
+    return true;
+}
+
+// Division and modulo by 2^s (s > 0) as shifts; negative dividends are
+// biased by 2^s - 1 first so that the quotient rounds toward zero.
+void laneShift(bool mod, long long *d, const long long *a, unsigned s, size_t n){
+    for(size_t k = 0; k < n; k++){
+        long long x = a[k], q = (x + (long long)((uint64_t)(x >> 63) >> (64 - s))) >> s;
+        d[k] = mod ? x - (long long)((uint64_t)q << s) : q;
+    }
+}
+
+#ifdef MINILANG_HAVE_AVX2
+// AVX2 has no 64-bit multiply: the low 64 bits are lo*lo plus the two cross
+// products shifted up.
+__attribute__((target("avx2"))) inline __m256i mul64x4(__m256i x, __m256i y){
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), y),
+                                     _mm256_mul_epu32(x, _mm256_srli_epi64(y, 32)));
+    return _mm256_add_epi64(_mm256_mul_epu32(x, y), _mm256_slli_epi64(cross, 32));
+}
+
+template<BinOp O> __attribute__((target("avx2"))) bool laneKernelAvx2(long long *d, const long long *a, const long long *b, size_t n){
+    const __m256i one = _mm256_set1_epi64x(1);
+    for(size_t k = 0; k < n; k += 4){
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + k)), y = _mm256_loadu_si256((const __m256i *)(b + k)), r;
+        if constexpr(O == BinOp::ADD) r = _mm256_add_epi64(x, y);
+        else if constexpr(O == BinOp::SUB) r = _mm256_sub_epi64(x, y);
+        else if constexpr(O == BinOp::MUL) r = mul64x4(x, y);
+        else if constexpr(O == BinOp::EQ)  r = _mm256_and_si256(_mm256_cmpeq_epi64(x, y), one);
+        else if constexpr(O == BinOp::NEQ) r = _mm256_andnot_si256(_mm256_cmpeq_epi64(x, y), one);
+        else if constexpr(O == BinOp::LT)  r = _mm256_and_si256(_mm256_cmpgt_epi64(y, x), one);
+        else if constexpr(O == BinOp::GT)  r = _mm256_and_si256(_mm256_cmpgt_epi64(x, y), one);
+        else if constexpr(O == BinOp::LTE) r = _mm256_andnot_si256(_mm256_cmpgt_epi64(x, y), one);
+        else r = _mm256_andnot_si256(_mm256_cmpgt_epi64(y, x), one);
+        _mm256_storeu_si256((__m256i *)(d + k), r);
+    }
+    return true;
+}
+#endif
+
+// The kernel of every BinOp, AVX2 where the CPU has it.
+const LaneKernel *laneKernels(){
+    static const LaneKernel portable[] = {
+        laneKernel<BinOp::ADD>, laneKernel<BinOp::SUB>, laneKernel<BinOp::MUL>, laneKernel<BinOp::DIV>,
+        laneKernel<BinOp::MOD>, laneKernel<BinOp::EQ>, laneKernel<BinOp::NEQ>, laneKernel<BinOp::LT>,
+        laneKernel<BinOp::GT>, laneKernel<BinOp::LTE>, laneKernel<BinOp::GTE>,
+    };
+#ifdef MINILANG_HAVE_AVX2
+    static const LaneKernel avx2[] = {
+        laneKernelAvx2<BinOp::ADD>, laneKernelAvx2<BinOp::SUB>, laneKernelAvx2<BinOp::MUL>, laneKernel<BinOp::DIV>,
+        laneKernel<BinOp::MOD>, laneKernelAvx2<BinOp::EQ>, laneKernelAvx2<BinOp::NEQ>, laneKernelAvx2<BinOp::LT>,
+        laneKernelAvx2<BinOp::GT>, laneKernelAvx2<BinOp::LTE>, laneKernelAvx2<BinOp::GTE>,
+    };
+    static const bool haveAvx2 = __builtin_cpu_supports("avx2");
+    if(haveAvx2) return avx2;
+#endif
+    return portable;
+}
+
+struct ParallelLoop {
+    uint32_t iv;                    // induction variable slot
+    long long step;
+    NodeKind cmp;                   // LT, LTE, GT or GTE
+    NodeId bound;                   // loop-invariant expression
+    vector<uint32_t> invariants;    // slots read but never assigned in the loop
+    vector<uint32_t> privates;      // slots every iteration assigns before reading
+    bool fallible = false;          // divides by something other than a literal besides 0 and -1
+    bool straight = true;           // the body holds assignments and prints only
+    LaneProgram lanes;              // straight bodies, with simd
+};
+
+struct ParallelLoops {
+    vector<int32_t> planOf;         // per NodeId: index into plans, or -1
+    vector<ParallelLoop> plans;
+    size_t threads = 1;
+    bool simd = false;              // run straight-line bodies over lanes
+
+    // Shorter loops are not worth waking the pool for, or filling lanes for.
+    static constexpr uint64_t MIN_TRIPS = 1024;
+    static constexpr uint64_t MIN_VECTOR_TRIPS = 16;
+
+    // Analysis stops after visiting this many nodes per AST node, so nested
+    // loops that are all rejected late cannot make it quadratic; loops left
+    // over simply run sequentially.
+    static constexpr size_t BUDGET_PER_NODE = 8;
+    size_t budget = 0;
+
+    // Per-slot scratch, cleared after each loop.
+    vector<char> assigned, defined, invariant;
+    vector<uint32_t> touched, scoped;
+    vector<NodeId> walk;
+    struct Open { NodeId id; uint32_t k; size_t mark; };
+    vector<Open> open;
+
+    const ParallelLoop *find(NodeId id) const {
+        return id < planOf.size() && planOf[id] >= 0 ? &plans[planOf[id]] : nullptr;
+    }
+
+    // Plans every parallelizable while under root.  Loops nested in an
+    // accepted one are not analyzed: its iterations run sequentially on the
+    // workers.
+    void analyze(const Ast &ast, NodeId root, bool trace){
+        planOf.assign(ast.nodes.size(), -1);
+        size_t slots = ast.names.size();
+        assigned.assign(slots, 0);
+        defined.assign(slots, 0);
+        invariant.assign(slots, 0);
+        budget = BUDGET_PER_NODE * ast.nodes.size();
+        vector<NodeId> todo{root};
+        while(!todo.empty()){
+            NodeId id = todo.back();
+            todo.pop_back();
+            const Node &n = ast[id];
+            switch(n.kind){
+                case NodeKind::BLOCK:
+                    for(uint32_t k = n.b; k-- > 0; ) todo.push_back(ast.stmts(id)[k]);
+                    break;
+                case NodeKind::IF:
+                    if(n.c != NO_NODE) todo.push_back(n.c);
+                    todo.push_back(n.b);
+                    break;
+                case NodeKind::WHILE: {
+                    ParallelLoop plan;
+                    if(budget && analyzeLoop(ast, id, plan)){
+                        if(trace) cout << "[OPTIMIZATION] " << (threads > 1 && !plan.fallible ? "Parallel" : "Vectorized")
+                                       << " loop at line " << n.line << ": iterations depend only on " << ast.names.names[plan.iv]
+                                       << (threads > 1 && !plan.fallible && simd && plan.straight ? " (vectorized)" : "") << endl;
+                        planOf[id] = plans.size();
+                        plans.push_back(move(plan));
+                    } else todo.push_back(n.b);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+
+    bool isVar(const Ast &ast, NodeId e, uint32_t slot){ return ast[e].kind == NodeKind::VAR && ast[e].a == slot; }
+
+    // Reads in e are of i, of invariants or of variables defined earlier in
+    // the iteration; a division that might fail makes the plan fallible.
+    bool checkExpr(const Ast &ast, NodeId e, uint32_t iv, ParallelLoop &plan){
+        bool ok = true;
+        ast.postOrder(e, walk, [&](NodeId id){
+            const Node &n = ast[id];
+            if(budget) budget--;
+            if(n.kind == NodeKind::BIGLIT) ok = false;
+            else if(n.kind == NodeKind::VAR){
+                uint32_t v = n.a;
+                if(v == iv || defined[v]) return;
+                if(assigned[v]){
+                    ok = false;
+                    return;
+                }
+                if(!invariant[v]){
+                    invariant[v] = 1;
+                    touched.push_back(v);
+                }
+            } else if(n.isBinary() && (n.op() == BinOp::DIV || n.op() == BinOp::MOD)){
+                const Node &d = ast[n.b];
+                if(d.kind != NodeKind::INT || d.value() == 0 || d.value() == -1) plan.fallible = true;
+            }
+        });
+        return ok && budget;
+    }
+
+    bool analyzeLoop(const Ast &ast, NodeId w, ParallelLoop &plan){
+        const Node &loop = ast[w], &cond = ast[loop.a], &body = ast[loop.b];
+        if(cond.kind != NodeKind::LT && cond.kind != NodeKind::LTE && cond.kind != NodeKind::GT && cond.kind != NodeKind::GTE) return false;
+        if(ast[cond.a].kind != NodeKind::VAR || body.b == 0) return false;
+        uint32_t iv = ast[cond.a].a;
+        const Node &inc = ast[ast.stmts(loop.b)[body.b - 1]];
+        if(inc.kind != NodeKind::ASSIGN || inc.a != iv) return false;
+        const Node &next = ast[inc.b];
+        long long step;
+        if(next.kind == NodeKind::ADD && isVar(ast, next.a, iv) && ast[next.b].kind == NodeKind::INT) step = ast[next.b].value();
+        else if(next.kind == NodeKind::ADD && isVar(ast, next.b, iv) && ast[next.a].kind == NodeKind::INT) step = ast[next.a].value();
+        else if(next.kind == NodeKind::SUB && isVar(ast, next.a, iv) && ast[next.b].kind == NodeKind::INT && ast[next.b].value() != LLONG_MIN)
+            step = -ast[next.b].value();
+        else return false;
+        bool up = cond.kind == NodeKind::LT || cond.kind == NodeKind::LTE;
+        if(up ? step <= 0 : step >= 0) return false;
+        plan = ParallelLoop();
+        plan.iv = iv;
+        plan.step = step;
+        plan.cmp = cond.kind;
+        plan.bound = cond.b;
+
+        // Every slot the body assigns, and how often it assigns i.
+        size_t ivAssigns = 0;
+        ast.postOrder(loop.b, walk, [&](NodeId id){
+            const Node &n = ast[id];
+            if(budget) budget--;
+            if(n.kind != NodeKind::ASSIGN) return;
+            ivAssigns += n.a == iv;
+            if(!assigned[n.a]){
+                assigned[n.a] = 1;
+                touched.push_back(n.a);
+            }
+        });
+        bool ok = ivAssigns == 1 && budget && checkExpr(ast, cond.b, UINT32_MAX, plan);
+
+        // The body in execution order.  Statements of the body itself define
+        // their variable for the rest of the iteration; inside an if or a
+        // nested while the definition lasts until that block ends.
+        for(uint32_t k = 0; ok && k + 1 < body.b; k++){
+            NodeKind kind = ast[ast.stmts(loop.b)[k]].kind;
+            plan.straight = plan.straight && (kind == NodeKind::ASSIGN || kind == NodeKind::PRINT);
+            open.push_back({ast.stmts(loop.b)[k], 0, scoped.size()});
+            bool top = true;
+            while(ok && !open.empty()){
+                Open &o = open.back();
+                const Node &n = ast[o.id];
+                switch(n.kind){
+                    case NodeKind::ASSIGN:
+                        ok = n.a != iv && checkExpr(ast, n.b, iv, plan);
+                        if(!defined[n.a]){
+                            defined[n.a] = 1;
+                            (top ? touched : scoped).push_back(n.a);
+                        }
+                        open.pop_back();
+                        break;
+                    case NodeKind::PRINT:
+                        ok = checkExpr(ast, n.a, iv, plan);
+                        open.pop_back();
+                        break;
+                    case NodeKind::BLOCK:
+                        if(o.k < n.b){
+                            open.push_back({ast.stmts(o.id)[o.k++], 0, scoped.size()});
+                            top = false;
+                            break;
+                        }
+                        for(size_t s = o.mark; s < scoped.size(); s++) defined[scoped[s]] = 0;
+                        scoped.resize(o.mark);
+                        open.pop_back();
+                        break;
+                    case NodeKind::IF: {
+                        ok = checkExpr(ast, n.a, iv, plan);
+                        size_t mark = o.mark;
+                        open.pop_back();
+                        if(n.c != NO_NODE) open.push_back({n.c, 0, mark});
+                        open.push_back({n.b, 0, mark});
+                        top = false;
+                        break;
+                    }
+                    case NodeKind::WHILE: {
+                        ok = checkExpr(ast, n.a, iv, plan);
+                        size_t mark = o.mark;
+                        open.pop_back();
+                        open.push_back({n.b, 0, mark});
+                        top = false;
+                        break;
+                    }
+                    default:
+                        ok = false;
+                        break;
+                }
+            }
+            open.clear();
+            for(uint32_t v : scoped) defined[v] = 0;
+            scoped.clear();
+        }
+        for(uint32_t v : touched){
+            if(v == iv || !assigned[v]) continue;
+            if(!defined[v]) ok = false;
+            plan.privates.push_back(v);
+        }
+        for(uint32_t v : touched){
+            if(invariant[v]) plan.invariants.push_back(v);
+            assigned[v] = defined[v] = invariant[v] = 0;
+        }
+        touched.clear();
+        sort(plan.privates.begin(), plan.privates.end());
+        plan.privates.erase(unique(plan.privates.begin(), plan.privates.end()), plan.privates.end());
+        sort(plan.invariants.begin(), plan.invariants.end());
+        plan.invariants.erase(unique(plan.invariants.begin(), plan.invariants.end()), plan.invariants.end());
+        bool vector = simd && plan.straight;
+        if(!ok || !(vector || (threads > 1 && !plan.fallible))) return false;
+        if(vector) compileLanes(ast, loop.b, plan);
+        return true;
+    }
+
+    // The body without its final i = i + c, over lanes.  A variable's
+    // register is that of the expression last assigned to it, so
+    // assignments cost nothing.
+    void compileLanes(const Ast &ast, NodeId body, ParallelLoop &plan){
+        LaneProgram &lp = plan.lanes;
+        unordered_map<uint32_t, uint32_t> reg{{plan.iv, 0}};
+        vector<uint32_t> regs;
+        for(uint32_t k = 0; k + 1 < ast[body].b; k++){
+            const Node &s = ast[ast.stmts(body)[k]];
+            ast.postOrder(s.kind == NodeKind::ASSIGN ? s.b : s.a, walk, [&](NodeId id){
+                const Node &e = ast[id];
+                if(e.kind == NodeKind::INT){
+                    lp.setup.push_back({NodeKind::INT, lp.regs, e.a, e.b});
+                    regs.push_back(lp.regs++);
+                } else if(e.kind == NodeKind::VAR){
+                    auto it = reg.find(e.a);
+                    if(it == reg.end()){            // an invariant
+                        it = reg.emplace(e.a, lp.regs++).first;
+                        lp.setup.push_back({NodeKind::VAR, it->second, e.a, 0});
+                    }
+                    regs.push_back(it->second);
+                } else {
+                    uint32_t b = regs.back();
+                    regs.pop_back();
+                    LaneOp op{e.kind, lp.regs, regs.back(), b};
+                    const Node &d = ast[e.b];
+                    if((e.kind == NodeKind::DIV || e.kind == NodeKind::MOD) && d.kind == NodeKind::INT
+                       && d.value() > 1 && !(d.value() & (d.value() - 1)))
+                        op.shift = __builtin_ctzll(d.value());
+                    lp.ops.push_back(op);
+                    regs.back() = lp.regs++;
+                }
+            });
+            if(s.kind == NodeKind::ASSIGN) reg[s.a] = regs.back();
+            else lp.prints.push_back(regs.back());
+            regs.pop_back();
+        }
+        for(uint32_t v : plan.privates) lp.finals.push_back({v, reg[v]});
+    }
+};
+
+// Iterations of `while (i cmp bound)` when i starts at i0 and the body adds
+// `step` to it, and the value i ends with.  False when the loop would not
+// end before i wraps around (or step does not move i towards the bound).
+bool tripCount(NodeKind cmp, long long i0, long long step, long long bound, uint64_t &trips, long long &final){
+    bool up = cmp == NodeKind::LT || cmp == NodeKind::LTE;
+    if(up ? step <= 0 : step >= 0) return false;
+    __int128 stride = step > 0 ? (__int128)step : -(__int128)step;
+    __int128 span = up ? (__int128)bound - i0 : (__int128)i0 - bound;
+    if(cmp == NodeKind::LTE || cmp == NodeKind::GTE) span += 1;
+    __int128 n = span <= 0 ? 0 : (span + stride - 1) / stride;
+    __int128 last = i0 + n * step;
+    if(n > (__int128)UINT64_MAX || last < LLONG_MIN || last > LLONG_MAX) return false;
+    trips = (uint64_t)n;
+    final = (long long)last;
+    return true;
+}
+
+// Threads for parallel loops, started on first use and kept for the rest of
+// the process.  start(f) has every thread call f(w) with its index w, and
+// wait() returns once all of them have returned.  One loop at a time.
+struct LoopPool {
+    vector<thread> threads;
+    mutex lock, running;
+    condition_variable wake, idle;
+    function<void(size_t)> job;
+    uint64_t generation = 0;
+    size_t busy = 0;
+    bool stop = false;
+
+    explicit LoopPool(size_t n){
+        for(size_t w = 0; w < n; w++)
+            threads.emplace_back([this, w]{
+                uint64_t seen = 0;
+                for(;;){
+                    unique_lock<mutex> hold(lock);
+                    wake.wait(hold, [&]{ return stop || generation != seen; });
+                    if(stop) return;
+                    seen = generation;
+                    hold.unlock();
+                    job(w);
+                    hold.lock();
+                    if(--busy == 0) idle.notify_all();
+                }
+            });
+    }
+    ~LoopPool(){
+        {
+            lock_guard<mutex> hold(lock);
+            stop = true;
+        }
+        wake.notify_all();
+        for(thread &t : threads) t.join();
+    }
+
+    void start(function<void(size_t)> f){
+        running.lock();
+        lock_guard<mutex> hold(lock);
+        job = move(f);
+        busy = threads.size();
+        generation++;
+        wake.notify_all();
+    }
+    void wait(){
+        {
+            unique_lock<mutex> hold(lock);
+            idle.wait(hold, [&]{ return busy == 0; });
+        }
+        running.unlock();
+    }
+};
+
+// The pool for `threads` workers; a request for more threads replaces it.
+LoopPool &loopPool(size_t threads){
+    static unique_ptr<LoopPool> pool;
+    static mutex lock;
+    lock_guard<mutex> hold(lock);
+    if(!pool || pool->threads.size() < threads) pool = make_unique<LoopPool>(threads);
+    return *pool;
+}
+
+// Tree-walking executor over the flat AST.  Statements run from an explicit
+// stack of pending nodes and deep expressions from an explicit value stack,
+// so nesting depth is limited by memory, not by the C++ stack.
+// AstInterpreter<true> also times every statement for --profile, and
+// AstInterpreter<..., Num> computes with arbitrary precision for --bigint.
+template<bool PROFILE = false, class Value = long long>
+struct AstInterpreter {
+    const Ast &ast;
+    BasicFrame<Value> &env;
+    Profiler *prof;
+    struct Pending { NodeId id; uint32_t k; };   // k: statements (or branches) done
+    vector<Pending> pending;
+    vector<chrono::steady_clock::time_point> started;   // PROFILE: parallel to pending
+    vector<NodeId> walk;
+    vector<Value> values;
+    PrintSink &out = programOut;    // looked up once, not per print
+    LimbPool &pool = limbPool;
+    const ParallelLoops *loops = nullptr;   // loops that may run on the loop pool
+
+    AstInterpreter(const Ast &t, BasicFrame<Value> &f, Profiler *p = nullptr): ast(t), env(f), prof(p) {}
+
+    Value var(NodeId id){
+        uint32_t slot = ast[id].a;
+        if(!env.init[slot]){
+            errs()<<"[RUNTIME ERROR] Use of undefined variable '"<<ast.name(id)<<"'\n";
+            fail();
+        }
+        return env.slots[slot];
+    }
+
+    template<BinOp O> Value binary(const Node &n, unsigned depth){
+        Value A = eval(n.a, depth+1), B = eval(n.b, depth+1);
+        if constexpr(O==BinOp::DIV || O==BinOp::MOD){
+            if constexpr(is_same_v<Value, long long>) checkDivisor(A, B);
+            else if(isZero(B)){
+                errs()<<"[RUNTIME ERROR] Division by zero\n";
+                fail();
+            }
+        }
+        return applyBinOp<O>(A, B);
+    }
+
+    // Recursion is fastest for the shallow expressions real programs have;
+    // below MAX_DEPTH levels the rest of the subtree goes to evalDeep, so
+    // the C++ stack never holds more than MAX_DEPTH eval frames.
+    static constexpr unsigned MAX_DEPTH = 64;
+
+    Value eval(NodeId id, unsigned depth = 0){
+        const Node &n = ast[id];
+        if(depth >= MAX_DEPTH && n.isBinary()) return evalDeep(id);
+        switch(n.kind){
+            case NodeKind::INT: return n.value();
+            case NodeKind::BIGLIT: return bigLit(n);
+            case NodeKind::VAR: return var(id);
+            case NodeKind::ADD: return binary<BinOp::ADD>(n, depth);
+            case NodeKind::SUB: return binary<BinOp::SUB>(n, depth);
+            case NodeKind::MUL: return binary<BinOp::MUL>(n, depth);
+            case NodeKind::DIV: return binary<BinOp::DIV>(n, depth);
+            case NodeKind::MOD: return binary<BinOp::MOD>(n, depth);
+            case NodeKind::EQ:  return binary<BinOp::EQ>(n, depth);
+            case NodeKind::NEQ: return binary<BinOp::NEQ>(n, depth);
+            case NodeKind::LT:  return binary<BinOp::LT>(n, depth);
+            case NodeKind::GT:  return binary<BinOp::GT>(n, depth);
+            case NodeKind::LTE: return binary<BinOp::LTE>(n, depth);
+            case NodeKind::GTE: return binary<BinOp::GTE>(n, depth);
+            default:
+                errs()<<"[RUNTIME ERROR] Statement node used as an expression\n";
+                fail();
+        }
+    }
+
+    // Post-order evaluation on explicit stacks, for arbitrarily deep trees.
+    Value evalDeep(NodeId root){
+        ast.postOrder(root, walk, [&](NodeId e){
+            const Node &x = ast[e];
+            if(x.kind==NodeKind::INT) values.push_back(x.value());
+            else if(x.kind==NodeKind::BIGLIT) values.push_back(bigLit(x));
+            else if(x.kind==NodeKind::VAR) values.push_back(var(e));
+            else if(x.isBinary()){
+                Value r = move(values.back());
+                values.pop_back();
+                values.back() = runBinOp(x.op(), values.back(), r);
+            } else {
+                errs()<<"[RUNTIME ERROR] Statement node used as an expression\n";
+                fail();
+            }
+        });
+        Value v = move(values.back());
+        values.pop_back();
+        return v;
+    }
+
+    // Only a --bigint parse produces BIGLIT nodes.
+    Value bigLit(const Node &n){
+        if constexpr(is_same_v<Value, Num>) return ast.bigLits[n.a];
+        errs()<<"[RUNTIME ERROR] Integer literal out of range\n";
+        fail();
+    }
+
+    void print(long long v){ out.put(v); }
+    void print(Num v){
+        if(v.isSmall()) out.put(v.small());
+        else if(out.binary){
+            errs()<<"[RUNTIME ERROR] Value does not fit in 64 bits for --binary\n";
+            fail();
+        } else out.putText(v.toString());
+        collectIfDue();
+    }
+
+    // Between statements the only Nums alive are the variables and the
+    // literals, so that is where BigInt blocks are reclaimed.
+    void collectIfDue(){
+        if constexpr(is_same_v<Value, Num>){
+            if(!pool.due()) return;
+            for(const Num &v : env.slots) v.mark();
+            for(const Num &v : ast.bigLits) v.mark();
+            pool.sweep();
+        }
+    }
+
+    void enter(NodeId id){
+        pending.push_back({id, 0});
+        if constexpr(PROFILE) started.push_back(chrono::steady_clock::now());
+    }
+
+    // Blocks are not counted: they last as long as their statements.
+    void record(NodeId id, chrono::steady_clock::time_point start){
+        if(ast[id].kind != NodeKind::BLOCK){
+            prof->runs[id]++;
+            prof->nanos[id] += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    void leave(){
+        if constexpr(PROFILE){
+            record(pending.back().id, started.back());
+            started.pop_back();
+        }
+        pending.pop_back();
+    }
+
+    // Iterations per batch of a vectorized loop: a multiple of every vector
+    // width, and large enough to spread the dispatch of each operation.
+    static constexpr size_t LANES = 128;
+    vector<long long> lanes;        // LaneProgram registers, LANES values each
+    vector<long long> printed;      // a batch's prints, interleaved by iteration
+
+    // Runs iterations [lo, hi) of a planned loop whose i starts at i0.  The
+    // variables the body assigns (but not i) end as the last iteration
+    // leaves them.  With `simd` a straight body runs LANES iterations at a
+    // time through the lane kernels; a batch in which a division would fail
+    // goes through exec instead, which reports the error.
+    void runIterations(const ParallelLoop &plan, NodeId body, long long i0, uint64_t lo, uint64_t hi, bool simd){
+        if(!simd || !plan.straight){
+            env.slots[plan.iv] = (long long)(i0 + (__int128)lo * plan.step);
+            for(uint64_t t = lo; t < hi; t++) exec(body);
+            return;
+        }
+        const LaneProgram &lp = plan.lanes;
+        const LaneKernel *kernels = laneKernels();
+        lanes.resize(lp.regs * LANES);
+        long long *reg = lanes.data();
+        for(const LaneOp &op : lp.setup)
+            fill_n(reg + op.dst * LANES, LANES, op.kind == NodeKind::INT ? (long long)((uint64_t)op.b << 32 | op.a) : env.slots[op.a]);
+        bool inLanes = false;
+        for(uint64_t t = lo; t < hi; t += LANES){
+            size_t n = min<uint64_t>(LANES, hi - t);
+            long long base = (long long)(i0 + (__int128)t * plan.step);
+            for(size_t l = 0; l < LANES; l++) reg[l] = (long long)((uint64_t)base + l * (uint64_t)plan.step);
+            inLanes = true;
+            for(const LaneOp &op : lp.ops){
+                if(op.shift) laneShift(op.kind == NodeKind::MOD, reg + op.dst * LANES, reg + op.a * LANES, op.shift, n);
+                else if(!kernels[static_cast<int>(op.kind)](reg + op.dst * LANES, reg + op.a * LANES, reg + op.b * LANES, n)){
+                    inLanes = false;
+                    break;
+                }
+            }
+            if(!inLanes){
+                env.slots[plan.iv] = base;
+                for(size_t l = 0; l < n; l++) exec(body);
+                continue;
+            }
+            size_t np = lp.prints.size();
+            if(np == 1) out.putMany(reg + lp.prints[0] * LANES, n);
+            else if(np > 1){
+                printed.resize(np * LANES);
+                for(size_t l = 0; l < n; l++)
+                    for(size_t q = 0; q < np; q++) printed[l * np + q] = reg[lp.prints[q] * LANES + l];
+                out.putMany(printed.data(), n * np);
+            }
+        }
+        if(!inLanes) return;
+        size_t lastLane = (hi - lo - 1) % LANES;
+        for(auto [slot, r] : lp.finals){
+            env.slots[slot] = reg[r * LANES + lastLane];
+            env.init[slot] = true;
+        }
+    }
+
+    // Runs while `id` by its plan: on the loop pool when it cannot fail and
+    // has at least MIN_TRIPS iterations, else vectorized on this thread when
+    // its body is straight-line.  Otherwise returns false and leaves the loop
+    // to the caller.  Chunks of iterations are handed out in order, each to
+    // a worker with its own copy of the frame and its print output captured;
+    // this thread writes the captures in chunk order.  At most `window`
+    // chunks are in flight, which bounds the memory held for output.
+    bool runLoop(NodeId id){
+        const ParallelLoop *plan = loops->find(id);
+        if(!plan || !env.init[plan->iv]) return false;
+        for(uint32_t v : plan->invariants) if(!env.init[v]) return false;
+        long long i0 = env.slots[plan->iv], final;
+        uint64_t trips;
+        if(!tripCount(plan->cmp, i0, plan->step, eval(plan->bound), trips, final) || trips == 0) return false;
+        NodeId body = ast[id].b;
+        bool simd = loops->simd && plan->straight;
+        if(loops->threads < 2 || plan->fallible || trips < ParallelLoops::MIN_TRIPS){
+            if(!simd || trips < ParallelLoops::MIN_VECTOR_TRIPS) return false;
+            runIterations(*plan, body, i0, 0, trips, true);
+            env.slots[plan->iv] = final;
+            return true;
+        }
+
+        size_t threads = loops->threads, window = 4 * threads;
+        uint64_t per = clamp<uint64_t>(trips / (threads * 8), LANES, 1 << 16) / LANES * LANES;
+        uint64_t chunks = (trips + per - 1) / per;
+        struct Chunk { string output; bool ready = false; };
+        vector<Chunk> ring(window);
+        mutex lock;
+        condition_variable progress;
+        uint64_t claimed = 0, written = 0;
+        vector<long long> last(plan->privates.size());
+        bool binary = out.binary;
+        LoopPool &workers = loopPool(threads);
+        workers.start([&](size_t){
+            Frame frame = env;
+            AstInterpreter worker(ast, frame);
+            worker.out.binary = binary;
+            for(;;){
+                uint64_t k;
+                {
+                    unique_lock<mutex> hold(lock);
+                    progress.wait(hold, [&]{ return claimed == chunks || claimed < written + window; });
+                    if(claimed == chunks) break;
+                    k = claimed++;
+                }
+                Chunk &c = ring[k % window];
+                uint64_t lo = k * per, hi = min(trips, lo + per);
+                worker.out.capture = &c.output;
+                worker.runIterations(*plan, body, i0, lo, hi, simd);
+                worker.out.flush();
+                worker.out.capture = nullptr;
+                if(k == chunks - 1)
+                    for(size_t j = 0; j < last.size(); j++) last[j] = frame.slots[plan->privates[j]];
+                {
+                    lock_guard<mutex> hold(lock);
+                    c.ready = true;
+                }
+                progress.notify_all();
+            }
+        });
+        for(uint64_t k = 0; k < chunks; k++){
+            Chunk &c = ring[k % window];
+            {
+                unique_lock<mutex> hold(lock);
+                progress.wait(hold, [&]{ return c.ready; });
+            }
+            out.putBytes(c.output);
+            if(out.lineFlush) out.flush();
+            c.output.clear();
+            {
+                lock_guard<mutex> hold(lock);
+                c.ready = false;
+                written++;
+            }
+            progress.notify_all();
+        }
+        workers.wait();
+        env.slots[plan->iv] = final;
+        for(size_t j = 0; j < last.size(); j++){
+            env.slots[plan->privates[j]] = last[j];
+            env.init[plan->privates[j]] = true;
+        }
+        return true;
+    }
+
+    void assign(const Node &n){
+        env.slots[n.a] = eval(n.b);
+        env.init[n.a] = true;
+        collectIfDue();
+    }
+
+    void exec(NodeId id, unsigned depth = 0){
+        if(depth >= MAX_DEPTH){
+            execDeep(id);
+            return;
+        }
+        const Node &n = ast[id];
+        chrono::steady_clock::time_point start;
+        if constexpr(PROFILE) start = chrono::steady_clock::now();
+        switch(n.kind){
+            case NodeKind::PRINT:
+                print(eval(n.a));
+                break;
+            case NodeKind::ASSIGN:
+                assign(n);
+                break;
+            case NodeKind::BLOCK:
+                for(uint32_t k = 0; k < n.b; k++) exec(ast.stmts(id)[k], depth+1);
+                break;
+            case NodeKind::IF:
+                if(eval(n.a)) exec(n.b, depth+1);
+                else if(n.c != NO_NODE) exec(n.c, depth+1);
+                break;
+            case NodeKind::WHILE:
+                if constexpr(!PROFILE && is_same_v<Value, long long>)
+                    if(loops && runLoop(id)) break;
+                while(eval(n.a)){
+                    collectIfDue();
+                    exec(n.b, depth+1);
+                }
+                break;
+            default:
+                errs()<<"[RUNTIME ERROR] Expression node used as a statement\n";
+                fail();
+        }
+        if constexpr(PROFILE) record(id, start);
+    }
+
+    // The same walk on the explicit `pending` stack, for nesting deeper
+    // than MAX_DEPTH.
+    void execDeep(NodeId root){
+        enter(root);
+        while(!pending.empty()){
+            Pending &p = pending.back();
+            const Node &n = ast[p.id];
+            switch(n.kind){
+                case NodeKind::BLOCK: {
+                    if(p.k == n.b){
+                        leave();
+                        break;
+                    }
+                    NodeId s = ast.stmts(p.id)[p.k++];
+                    if constexpr(!PROFILE){
+                        // Straight-line statements run in place.
+                        const Node &sn = ast[s];
+                        if(sn.kind==NodeKind::ASSIGN){ assign(sn); break; }
+                        if(sn.kind==NodeKind::PRINT){ print(eval(sn.a)); break; }
+                    }
+                    enter(s);
+                    break;
+                }
+                case NodeKind::PRINT:
+                    print(eval(n.a));
+                    leave();
+                    break;
+                case NodeKind::ASSIGN:
+                    assign(n);
+                    leave();
+                    break;
+                case NodeKind::IF:
+                    if(p.k++){
+                        leave();
+                        break;
+                    }
+                    if(eval(n.a)) enter(n.b);
+                    else if(n.c != NO_NODE) enter(n.c);
+                    break;
+                case NodeKind::WHILE:
+                    if constexpr(!PROFILE && is_same_v<Value, long long>)
+                        if(!p.k++ && loops && runLoop(p.id)){
+                            leave();
+                            break;
+                        }
+                    if(eval(n.a)){
+                        collectIfDue();
+                        enter(n.b);
+                    } else leave();
+                    break;
+                default:
+                    errs()<<"[RUNTIME ERROR] Expression node used as a statement\n";
+                    fail();
+            }
+        }
+    }
+};
+
+// ============================================================================
+// PHASE 2: SYNTAX ANALYSIS - Parser Implementation
+// ============================================================================
+struct Parser {
+    Lexer lex;
+    Token cur;
+    bool debug;
+    Ast ast;
+    vector<NodeId> pending;    // statements of the blocks being parsed
+    string assignName;         // target of the assignment being parsed
+
+    // A statement whose block is still open: an if waiting for its then or
+    // else block, a while waiting for its body, or a plain `{ ... }`.
+    struct OpenStmt {
+        enum What : uint8_t { BLOCK, THEN, ELSE, WHILE } what;
+        int line;
+        NodeId cond, thenB;
+        size_t mark;           // its statements start at pending[mark]
+    };
+    vector<OpenStmt> open;
+
+    // Expression operators still waiting for their right operand.
+    struct PendingOp {
+        enum What : uint8_t { BINARY, NEGATE, PAREN } what;
+        BinOp op;
+        NodeId zero;           // NEGATE: the 0 of the 0 - x it becomes
+    };
+    vector<PendingOp> ops;
+    vector<NodeId> operands;
+
+    Parser(string_view s, bool dbg=false, bool bigint=false): lex(s, dbg), debug(dbg) {
+        lex.bigint = bigint;
+        cur = lex.nextToken();
+        if(debug) cout << "[PARSER] Initialized, first token: " << tokenTypeName(cur.type) << endl;
+    }
+
+    Parser(StreamSource &in, bool dbg=false, bool bigint=false): lex(in, dbg), debug(dbg) {
+        lex.bigint = bigint;
+        cur = lex.nextToken();
+        if(debug) cout << "[PARSER] Initialized, first token: " << tokenTypeName(cur.type) << endl;
+    }
+
+    void eat(TokenType t){
+        if(cur.type==t) {
+            if(debug) cout << "[PARSER] Consumed token: " << tokenTypeName(t) << endl;
+            cur = lex.nextToken();
+        } else {
+            errs()<<"[PARSER ERROR] Line " << cur.line << ": expected "<<tokenTypeName(t)<<" but got "<<tokenTypeName(cur.type)<<" ('"<<cur.text<<"')\n";
+            fail();
+        }
+    }
+
+    // Moves the statements parsed since `mark` into one BLOCK node.
+    NodeId closeBlock(size_t mark){
+        NodeId first = ast.lists.size();
+        ast.lists.insert(ast.lists.end(), pending.begin() + mark, pending.end());
+        pending.resize(mark);
+        return ast.add(NodeKind::BLOCK, first, ast.lists.size() - first);
+    }
+
+    Ast parseProgram(){
+        if(debug) cout << "[PARSER] Starting program parsing" << endl;
+        size_t mark = pending.size();
+        while(cur.type!=TokenType::END) {
+            pending.push_back(parseStatement());
+        }
+        ast.root = closeBlock(mark);
+        if(debug) {
+            cout << "[PARSER] Program parsing complete. AST:" << endl;
+            cout << ast.toString(ast.root) << endl;
+        }
+        return move(ast);
+    }
+
+    // Streaming: parses the next top-level statement as a one-statement
+    // block and returns it, or NO_NODE at end of input.  The caller runs it
+    // and then calls ast.clearNodes(), so only one statement is ever held.
+    NodeId parseTopLevel(){
+        if(cur.type==TokenType::END) return NO_NODE;
+        size_t mark = pending.size();
+        pending.push_back(parseStatement());
+        return ast.root = closeBlock(mark);
+    }
+
+    // Parses one whole statement, nested blocks included, without
+    // recursing: each `{` pushes an OpenStmt, and the matching `}` finishes
+    // it and hands the finished statement to the block around it.
+    NodeId parseStatement(){
+        size_t base = open.size();
+        for(;;){
+            NodeId done;
+            if(open.size() > base && cur.type==TokenType::RBRACE){
+                eat(TokenType::RBRACE);
+                OpenStmt o = open.back();
+                open.pop_back();
+                NodeId blk = closeBlock(o.mark);
+                switch(o.what){
+                    case OpenStmt::THEN:
+                        if(cur.type==TokenType::KW_ELSE){
+                            if(debug) cout << "[PARSER] Found else clause" << endl;
+                            eat(TokenType::KW_ELSE);
+                            openBlock(OpenStmt::ELSE, o.line, o.cond, blk);
+                            continue;
+                        }
+                        done = ast.stmt(NodeKind::IF, o.line, o.cond, blk, NO_NODE);
+                        break;
+                    case OpenStmt::ELSE:  done = ast.stmt(NodeKind::IF, o.line, o.cond, o.thenB, blk); break;
+                    case OpenStmt::WHILE: done = ast.stmt(NodeKind::WHILE, o.line, o.cond, blk); break;
+                    default:              done = blk; break;
+                }
+            } else {
+                done = startStatement();
+                if(done == NO_NODE) continue;       // it opened a block
+            }
+            if(open.size() == base) return done;
+            pending.push_back(done);
+        }
+    }
+
+    // Parses a statement up to its opening `{`, or all of it if it has none.
+    NodeId startStatement(){
+        if(debug) cout << "[PARSER] Parsing statement, current token: " << tokenTypeName(cur.type) << endl;
+        int line = cur.line;
+
+        if(cur.type==TokenType::KW_PRINT){
+            if(debug) cout << "[PARSER] Found print statement" << endl;
+            eat(TokenType::KW_PRINT);
+            eat(TokenType::LPAREN);
+            NodeId e=parseExpr();
+            eat(TokenType::RPAREN);
+            eat(TokenType::SEMI);
+            return ast.stmt(NodeKind::PRINT, line, e);
+        }
+        if(cur.type==TokenType::IDENT){
+            assignName.assign(cur.text);   // the token's text is gone once the lexer moves on
+            if(debug) cout << "[PARSER] Found assignment to variable: " << assignName << endl;
+            eat(TokenType::IDENT);
+            eat(TokenType::ASSIGN);
+            NodeId e=parseExpr();
+            eat(TokenType::SEMI);
+            // Resolved after the right-hand side, so slots are numbered in
+            // the order names are first read or written.
+            return ast.stmt(NodeKind::ASSIGN, line, ast.names.resolve(assignName), e);
+        }
+        if(cur.type==TokenType::KW_IF){
+            if(debug) cout << "[PARSER] Found if statement" << endl;
+            eat(TokenType::KW_IF);
+            eat(TokenType::LPAREN);
+            NodeId cond=parseExpr();
+            eat(TokenType::RPAREN);
+            openBlock(OpenStmt::THEN, line, cond);
+            return NO_NODE;
+        }
+        if(cur.type==TokenType::KW_WHILE){
+            if(debug) cout << "[PARSER] Found while statement" << endl;
+            eat(TokenType::KW_WHILE);
+            eat(TokenType::LPAREN);
+            NodeId cond=parseExpr();
+            eat(TokenType::RPAREN);
+            openBlock(OpenStmt::WHILE, line, cond);
+            return NO_NODE;
+        }
+        if(cur.type==TokenType::LBRACE) {
+            if(debug) cout << "[PARSER] Found block statement" << endl;
+            openBlock(OpenStmt::BLOCK, line, NO_NODE);
+            return NO_NODE;
+        }
+        errs()<<"[PARSER ERROR] Unexpected token "<<tokenTypeName(cur.type)<<" ('"<<cur.text<<"')\n";
+        fail();
+    }
+
+    void openBlock(OpenStmt::What what, int line, NodeId cond, NodeId thenB = NO_NODE){
+        eat(TokenType::LBRACE);
+        open.push_back({what, line, cond, thenB, pending.size()});
+    }
+
+    static bool isBinaryOperator(TokenType t){
+        switch(t){
+            case TokenType::PLUS: case TokenType::MINUS: case TokenType::MUL: case TokenType::DIV: case TokenType::MOD:
+            case TokenType::EQ: case TokenType::NEQ: case TokenType::LT: case TokenType::GT: case TokenType::LTE: case TokenType::GTE:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // 1 equality, 2 comparison, 3 term, 4 factor; all are left-associative.
+    static int precedence(BinOp op){
+        switch(op){
+            case BinOp::EQ: case BinOp::NEQ: return 1;
+            case BinOp::LT: case BinOp::GT: case BinOp::LTE: case BinOp::GTE: return 2;
+            case BinOp::ADD: case BinOp::SUB: return 3;
+            default: return 4;
+        }
+    }
+
+    // Pops the innermost binary operator and its two operands into a node.
+    void reduce(){
+        BinOp op = ops.back().op;
+        ops.pop_back();
+        NodeId right = operands.back();
+        operands.pop_back();
+        operands.back() = ast.add(static_cast<NodeKind>(op), operands.back(), right);
+    }
+
+    // Operator-precedence parsing on explicit stacks (shunting-yard), so
+    // neither parentheses nor prefix operators recurse.  Nodes come out in
+    // the same order recursive descent would create them.
+    NodeId parseExpr(){
+        static const char *level[] = { "", "Equality", "Comparison", "Term", "Factor" };
+        size_t opBase = ops.size();
+        int parens = 0;
+        for(;;){
+            // Operand position: prefix operators and `(`, then a primary.
+            if(cur.type==TokenType::PLUS){
+                if(debug) cout << "[PARSER] Unary plus" << endl;
+                eat(TokenType::PLUS);
+                continue;
+            }
+            if(cur.type==TokenType::MINUS){
+                if(debug) cout << "[PARSER] Unary minus" << endl;
+                eat(TokenType::MINUS);
+                ops.push_back({PendingOp::NEGATE, BinOp::SUB, ast.intLit(0)});
+                continue;
+            }
+            if(cur.type==TokenType::LPAREN){
+                if(debug) cout << "[PARSER] Parenthesized expression" << endl;
+                eat(TokenType::LPAREN);
+                ops.push_back({PendingOp::PAREN, BinOp::ADD, NO_NODE});
+                parens++;
+                continue;
+            }
+            operands.push_back(parsePrimary());
+
+            // Operator position.  A unary minus applies to the primary (or
+            // parenthesized expression) just completed.
+            for(;;){
+                while(ops.size() > opBase && ops.back().what==PendingOp::NEGATE){
+                    operands.back() = ast.add(NodeKind::SUB, ops.back().zero, operands.back());
+                    ops.pop_back();
+                }
+                if(parens == 0 || cur.type!=TokenType::RPAREN) break;
+                while(ops.back().what!=PendingOp::PAREN) reduce();
+                ops.pop_back();
+                parens--;
+                eat(TokenType::RPAREN);
+            }
+            if(!isBinaryOperator(cur.type)) break;
+            BinOp op=binOpFor(cur.type);
+            int prec=precedence(op);
+            if(debug) cout << "[PARSER] " << level[prec] << " operator: " << binOpText(op) << endl;
+            while(ops.size() > opBase && ops.back().what==PendingOp::BINARY && precedence(ops.back().op) >= prec) reduce();
+            ops.push_back({PendingOp::BINARY, op, NO_NODE});
+            eat(cur.type);
+        }
+        if(parens > 0) eat(TokenType::RPAREN);     // reports the missing ')'
+        while(ops.size() > opBase) reduce();
+        NodeId e = operands.back();
+        operands.pop_back();
+        return e;
+    }
+
+    NodeId parsePrimary(){
+        if(cur.type==TokenType::INT_LIT && cur.big){
+            if(debug) cout << "[PARSER] Integer literal: " << cur.text << endl;
+            NodeId e = ast.bigLit(cur.text);
+            eat(TokenType::INT_LIT);
+            return e;
+        } else if(cur.type==TokenType::INT_LIT){
+            long long v=cur.intVal;
+            if(debug) cout << "[PARSER] Integer literal: " << v << endl;
+            eat(TokenType::INT_LIT);
+            return ast.intLit(v);
+        } else if(cur.type==TokenType::IDENT){
+            int slot=ast.names.resolve(cur.text);
+            if(debug) cout << "[PARSER] Variable: " << cur.text << endl;
+            eat(TokenType::IDENT);
+            return ast.add(NodeKind::VAR, slot);
+        }
+        errs()<<"[PARSER ERROR] Unexpected primary token\n";
+        fail();
+    }
+};
+
+// ============================================================================
+// PHASE 3: SEMANTIC ANALYSIS
+// ============================================================================
+// `defined` is indexed by slot.  Names assigned inside an if branch or a
+// while body stay local to it: each first definition there is pushed on an
+// undo log, and leaving the branch clears those slots again, so nothing is
+// copied and the whole check is linear in the size of the program.
+struct SemanticChecker {
+    const Ast &ast;
+    vector<bool> &defined;
+    vector<uint32_t> undo;     // slots first defined inside the open branches
+    vector<NodeId> walk;
+    bool trace, debug;
+
+    // Blocks being checked, and the if/while statements whose branches are,
+    // innermost last.  For an if or while, k counts its branches checked and
+    // mark is the undo log height when the current one began.
+    struct Pending { NodeId id; uint32_t k; int depth; bool scoped; size_t mark; };
+    vector<Pending> open;
+
+    SemanticChecker(const Ast &t, vector<bool> &d, bool tr, bool dbg): ast(t), defined(d), trace(tr), debug(dbg) {}
+
+    // Trace lines end in '\n', not endl: a diagnostic on cerr flushes stdout
+    // first anyway (see PrintSink::flush), so nothing needs a flush per line.
+    ostream &log(int depth){ return cout << setw(depth*2) << "" << "[SEMANTIC] "; }
+
+    // Checks every variable read by e; `valid` is the -d message for a good use.
+    void uses(NodeId e, const char *valid, int depth){
+        ast.postOrder(e, walk, [&](NodeId v){
+            const Node &n = ast[v];
+            if(n.kind!=NodeKind::VAR) return;
+            if(!defined[n.a]){
+                errs()<<"[SEMANTIC ERROR] Variable '"<<ast.name(v)<<"' used before assignment\n";
+                fail();
+            }
+            if(valid && debug) log(depth) << valid << ast.name(v) << '\n';
+        });
+    }
+
+    // Drops the definitions made since the current branch began.
+    void endBranch(size_t mark){
+        for(size_t k = mark; k < undo.size(); k++) defined[undo[k]] = false;
+        undo.resize(mark);
+    }
+
+    // Checks statement s of a block; if, while and nested blocks are pushed
+    // and finished by block().
+    void statement(NodeId s, int depth, bool scoped){
+        const Node &n = ast[s];
+        if(n.kind==NodeKind::ASSIGN){
+            if(trace) log(depth) << "Checking assignment to: " << ast.name(s) << '\n';
+            uses(n.b, "Valid use of variable: ", depth);
+            if(!defined[n.a]){
+                defined[n.a] = true;
+                if(scoped) undo.push_back(n.a);
+            }
+            if(trace) log(depth) << "Variable defined: " << ast.name(s) << '\n';
+
+        } else if(n.kind==NodeKind::IF){
+            if(trace) log(depth) << "Checking if statement condition" << '\n';
+            uses(n.a, nullptr, depth);
+            if(trace) log(depth) << "Checking then block..." << '\n';
+            open.push_back({s, 1, depth, scoped, undo.size()});
+            open.push_back({n.b, 0, depth+1, true, 0});
+
+        } else if(n.kind==NodeKind::WHILE){
+            if(trace) log(depth) << "Checking while statement condition" << '\n';
+            uses(n.a, nullptr, depth);
+            if(trace) log(depth) << "Checking while loop body..." << '\n';
+            open.push_back({s, 1, depth, scoped, undo.size()});
+            open.push_back({n.b, 0, depth+1, true, 0});
+
+        } else if(n.kind==NodeKind::BLOCK){
+            if(trace) log(depth) << "Checking nested block..." << '\n';
+            open.push_back({s, 0, depth+1, scoped, 0});
+
+        } else if(n.kind==NodeKind::PRINT){
+            if(trace) log(depth) << "Checking print statement" << '\n';
+            uses(n.a, "Valid use in print: ", depth);
+        }
+    }
+
+    void block(NodeId blk, int depth, bool scoped){
+        open.push_back({blk, 0, depth, scoped, 0});
+        while(!open.empty()){
+            Pending &p = open.back();
+            const Node &n = ast[p.id];
+            if(n.kind==NodeKind::BLOCK){
+                if(p.k == n.b) open.pop_back();
+                else statement(ast.stmts(p.id)[p.k++], p.depth, p.scoped);
+                continue;
+            }
+            // An if or while whose current branch is done.
+            endBranch(p.mark);
+            if(n.kind==NodeKind::IF && p.k==1 && n.c != NO_NODE){
+                p.k = 2;
+                if(trace) log(p.depth) << "Checking else block..." << '\n';
+                int depth = p.depth + 1;
+                open.push_back({n.c, 0, depth, true, 0});
+            } else {
+                open.pop_back();
+            }
+        }
+    }
+};
+
+// Definitions made at the top level of `blk` stay in `defined` (the
+// streaming runner relies on that across statements).
+void semanticCheckBlock(const Ast &ast, NodeId blk, vector<bool>& defined, bool trace=true, bool debug=false){
+    if(trace) cout << "[SEMANTIC] Starting semantic analysis..." << endl;
+    SemanticChecker(ast, defined, trace, debug).block(blk, 0, false);
+    if(trace) cout << "[SEMANTIC] Semantic analysis completed successfully!" << endl;
+}
+
+// ============================================================================
+// PHASE 5: OPTIMIZATION - Constant Folding
+// ============================================================================
+// Folds in place: a binary node over two literals becomes a literal (its
+// children simply stay behind, unreferenced).  Children are folded first,
+// so one post-order walk folds whole constant subtrees.
+void foldNode(Ast &ast, NodeId e, bool trace, bool exact = false){
+    Node &n = ast[e];
+    if(!n.isBinary()) return;
+    const Node &A = ast[n.a], &B = ast[n.b];
+    if(A.kind==NodeKind::INT && B.kind==NodeKind::INT){
+        long long av = A.value(), bv = B.value();
+        long long r=0;
+        bool ok=evalBinOp(n.op(), av, bv, r, exact);
+
+        if(ok) {
+            if(trace) cout << "[OPTIMIZATION] Constant folded: " << av << " " << binOpText(n.op()) << " " << bv << " = " << r << endl;
+            n = {NodeKind::INT, 0, (uint32_t)(uint64_t)r, (uint32_t)((uint64_t)r >> 32)};
+        }
+    }
+}
+
+// Scalar evolution, for replacing loops without prints by their results.
+// The value a variable has at the start of iteration k is modeled as an
+// add-recurrence in Newton form: {c0, +, c1, +, c2, ...} is worth
+// c0 + c1*C(k,1) + c2*C(k,2) + ...  A variable the body increases by a
+// recurrence {e0, +, e1, ...} is then {start, +, e0, +, e1, ...}, so sums of
+// polynomials in the induction variable stay polynomials.  The coefficients
+// of +, - and * on this form are integers, so everything is computed modulo
+// 2^64 exactly as the program itself would; with `exact` (--bigint) a step
+// that would overflow gives up instead.
+struct ScalarEvolution {
+    typedef vector<long long> Rec;                  // Newton coefficients
+    typedef map<vector<uint32_t>, long long> Poly;  // sorted slots (a monomial) -> coefficient
+    static constexpr size_t MAX_DEGREE = 8, MAX_TERMS = 64;
+    bool exact = false;
+
+    bool op(BinOp o, long long a, long long b, long long &r) const { return evalBinOp(o, a, b, r, exact); }
+
+    static Poly constant(long long v){ return v ? Poly{{{}, v}} : Poly(); }
+    static Poly symbol(uint32_t slot){ return Poly{{{slot}, 1}}; }
+    static bool mentions(const Poly &p, uint32_t slot){
+        for(const auto &[m, c] : p) if(find(m.begin(), m.end(), slot) != m.end()) return true;
+        return false;
+    }
+
+    // a += b, or a -= b.
+    bool add(Poly &a, const Poly &b, bool subtract) const {
+        for(const auto &[m, c] : b){
+            long long &t = a[m];
+            if(!op(subtract ? BinOp::SUB : BinOp::ADD, t, c, t)) return false;
+            if(!t) a.erase(m);
+        }
+        return a.size() <= MAX_TERMS;
+    }
+    bool mul(const Poly &a, const Poly &b, Poly &r) const {
+        r.clear();
+        for(const auto &[ma, ca] : a)
+            for(const auto &[mb, cb] : b){
+                if(ma.size() + mb.size() > MAX_DEGREE) return false;
+                vector<uint32_t> m;
+                merge(ma.begin(), ma.end(), mb.begin(), mb.end(), back_inserter(m));
+                long long c;
+                if(!op(BinOp::MUL, ca, cb, c) || !add(r, Poly{{m, c}}, false)) return false;
+            }
+        return true;
+    }
+
+    static void trim(Rec &a){ while(a.size() > 1 && a.back() == 0) a.pop_back(); }
+    bool add(const Rec &a, const Rec &b, Rec &r) const {
+        r.assign(max(a.size(), b.size()), 0);
+        for(size_t j = 0; j < r.size(); j++)
+            if(!op(BinOp::ADD, j < a.size() ? a[j] : 0, j < b.size() ? b[j] : 0, r[j])) return false;
+        trim(r);
+        return true;
+    }
+    // C(k,i) * C(k,j) is the sum over t of C(t,i) * C(i,t-j) * C(k,t).
+    bool mul(const Rec &a, const Rec &b, Rec &r) const {
+        if(a.size() + b.size() - 1 > MAX_DEGREE + 1) return false;
+        r.assign(a.size() + b.size() - 1, 0);
+        for(size_t i = 0; i < a.size(); i++)
+            for(size_t j = 0; j < b.size(); j++){
+                long long ab, term;
+                if(!a[i] || !b[j]) continue;
+                if(!op(BinOp::MUL, a[i], b[j], ab)) return false;
+                for(size_t t = max(i, j); t <= i + j; t++)
+                    if(!op(BinOp::MUL, ab, smallBinomial(t, i) * smallBinomial(i, t - j), term) || !op(BinOp::ADD, r[t], term, r[t]))
+                        return false;
+            }
+        trim(r);
+        return true;
+    }
+    static long long smallBinomial(uint64_t n, uint64_t k){
+        long long c = 1;
+        for(uint64_t t = 0; t < k; t++) c = c * (n - t) / (t + 1);
+        return c;
+    }
+
+    // The recurrence of p, with each slot replaced by its recurrence in `rec`.
+    bool substitute(const Poly &p, const unordered_map<uint32_t, Rec> &rec, Rec &r) const {
+        r = {0};
+        for(const auto &[m, c] : p){
+            Rec t{c}, u;
+            for(uint32_t slot : m){
+                if(!mul(t, rec.at(slot), u)) return false;
+                t.swap(u);
+            }
+            if(!add(r, t, u)) return false;
+            r.swap(u);
+        }
+        return true;
+    }
+
+    // C(k, j): exactly, or with `exact` false when it does not fit in 64
+    // bits; otherwise modulo 2^64, from the odd parts of the numerator and
+    // denominator (the odd part of j! is inverted by Newton's iteration)
+    // and the power of two left over.
+    bool binomial(uint64_t k, size_t j, long long &r) const {
+        if(j > k){
+            r = 0;
+            return true;
+        }
+        if(exact){
+            __int128 c = 1;
+            for(size_t t = 0; t < j; t++){
+                c = c * (__int128)(k - t) / (t + 1);
+                if(c > LLONG_MAX) return false;
+            }
+            r = (long long)c;
+            return true;
+        }
+        uint64_t num = 1, den = 1;
+        int twos = 0;
+        for(size_t t = 0; t < j; t++){
+            uint64_t x = k - t, y = t + 1;
+            int zx = __builtin_ctzll(x), zy = __builtin_ctzll(y);
+            num *= x >> zx;
+            den *= y >> zy;
+            twos += zx - zy;
+        }
+        uint64_t inv = den;
+        for(int round = 0; round < 5; round++) inv *= 2 - den * inv;
+        r = twos >= 64 ? 0 : (long long)(num * inv << twos);
+        return true;
+    }
+
+    // The value of a at iteration k.
+    bool at(const Rec &a, uint64_t k, long long &r) const {
+        r = 0;
+        for(size_t j = 0; j < a.size(); j++){
+            long long c, term;
+            if(!a[j]) continue;
+            if(!binomial(k, j, c) || !op(BinOp::MUL, a[j], c, term) || !op(BinOp::ADD, r, term, r)) return false;
+        }
+        return true;
+    }
+};
+
+// Constant propagation over the whole program, on top of foldNode.  The
+// statements are walked in execution order with the value of every variable
+// known to be constant; a use of such a variable becomes a literal.  Like
+// the semantic checker, branches record what they change in an undo log: an
+// if keeps a constant afterwards only when both branches leave it equal, and
+// a while forgets, on entry and on exit, every variable assigned anywhere in
+// its body.  Along the way it applies the identities x+0, x-0, x*1, x/1,
+// x*0 and x-x, replaces an if whose condition folds to a constant by the
+// branch taken, and removes a while whose condition is false on entry.  A
+// while of assignments only, counted by an induction variable, whose state
+// on entry is known, is replaced by the values it ends with (closedForm).
+// Rewrites are in place; what they drop stays behind unreferenced.
+struct ConstantFolder {
+    Ast &ast;
+    bool trace;
+    bool exact = false;         // --bigint: never fold a result that overflows
+    vector<long long> value;    // per slot, when known
+    vector<char> known;
+    struct Undo { uint32_t slot; char known; long long value; };
+    vector<Undo> undo;
+    vector<uint32_t> stamp;     // per slot: scratch for deduplicating slot lists
+
+    // Slots assigned inside each while (nested loops included), as spans of
+    // `kills`.
+    vector<uint32_t> kills;
+    unordered_map<NodeId, pair<uint32_t, uint32_t>> loopKills;
+
+    vector<NodeId> walk;
+    vector<char> fallible;      // per pending operand: may raise a runtime error
+    vector<long long> values;
+
+    // Blocks being folded, and the if/while statements around them,
+    // innermost last.  For an if, k counts the branches done, mark is the
+    // undo log height when it began and then is where its then branch's
+    // results start in `thenState`.
+    struct Pending { NodeId id; uint32_t k; size_t mark, then; };
+    vector<Pending> open;
+    vector<Undo> thenState;
+
+    ConstantFolder(Ast &t, bool tr): ast(t), trace(tr) {}
+
+    void set(uint32_t slot, bool k, long long v = 0){
+        if(known[slot] == k && (!k || value[slot] == v)) return;
+        undo.push_back({slot, known[slot], value[slot]});
+        known[slot] = k;
+        value[slot] = v;
+    }
+
+    // One post-order pass over the program: the assignments below a node
+    // collect on a stack, and a while collapses the ones of its body into its
+    // distinct slots, so nested loops cost the size of their slot sets.
+    void findLoopKills(NodeId root){
+        vector<uint32_t> assigned;
+        vector<uint32_t> start(ast.nodes.size());
+        uint32_t loops = 0;
+        ast.postOrder(root, walk, [&](NodeId id){
+            const Node &n = ast[id];
+            NodeId first = NO_NODE;
+            switch(n.kind){
+                case NodeKind::INT: case NodeKind::BIGLIT: case NodeKind::VAR: break;
+                case NodeKind::PRINT:  first = n.a; break;
+                case NodeKind::ASSIGN: first = n.b; break;
+                case NodeKind::BLOCK:  if(n.b) first = ast.stmts(id)[0]; break;
+                default:               first = n.a; break;
+            }
+            start[id] = first == NO_NODE ? assigned.size() : start[first];
+            if(n.kind == NodeKind::ASSIGN) assigned.push_back(n.a);
+            if(n.kind != NodeKind::WHILE) return;
+            loops++;
+            uint32_t from = kills.size();
+            for(size_t k = start[id]; k < assigned.size(); k++)
+                if(stamp[assigned[k]] != loops){
+                    stamp[assigned[k]] = loops;
+                    kills.push_back(assigned[k]);
+                }
+            loopKills[id] = {from, (uint32_t)kills.size()};
+            assigned.resize(start[id]);
+            assigned.insert(assigned.end(), kills.begin() + from, kills.end());
+        });
+        fill(stamp.begin(), stamp.end(), 0);
+    }
+
+    void forgetLoop(NodeId w){
+        auto [from, to] = loopKills[w];
+        for(uint32_t k = from; k < to; k++) set(kills[k], false);
+    }
+
+    static void replace(Node &n, const Node &with){
+        uint32_t line = n.line;
+        n = with;
+        n.line = line;
+    }
+    void makeEmpty(NodeId s){ replace(ast[s], {NodeKind::BLOCK, 0, 0, 0}); }
+
+    // Loops are solved only up to this size, which keeps the analysis of
+    // each one constant.
+    static constexpr uint32_t MAX_CLOSED_FORM_NODES = 512;
+
+    // Replaces while s by assignments of the values its variables end with.
+    // The body must be assignments of +, - and * only, the condition i < n,
+    // i <= n, i > n or i >= n with n not assigned in the loop, and the values
+    // of i, n and everything the body reads known here.  One symbolic pass
+    // over the body gives every assigned variable's value at the end of an
+    // iteration as a polynomial in the values at its start.  A variable the
+    // body increases by a polynomial of variables already solved is an
+    // accumulator, {start, +, increase}; one whose new value does not depend
+    // on its old one (a temporary) ends with its value in the last iteration.
+    // i must come out as {i0, +, c}, which gives the trip count.
+    bool closedForm(NodeId s){
+        typedef ScalarEvolution::Poly Poly;
+        typedef ScalarEvolution::Rec Rec;
+        const Node &loop = ast[s], &cond = ast[loop.a];
+        NodeId body = loop.b;
+        uint32_t line = loop.line, count = ast[body].b;
+        if(cond.kind != NodeKind::LT && cond.kind != NodeKind::LTE && cond.kind != NodeKind::GT && cond.kind != NodeKind::GTE) return false;
+        if(ast[cond.a].kind != NodeKind::VAR || count == 0 || count > MAX_CLOSED_FORM_NODES) return false;
+        uint32_t iv = ast[cond.a].a;
+        vector<uint32_t> variant;       // in order of first assignment
+        for(uint32_t k = 0; k < count; k++){
+            const Node &a = ast[ast.stmts(body)[k]];
+            if(a.kind != NodeKind::ASSIGN) return false;
+            if(find(variant.begin(), variant.end(), a.a) == variant.end()) variant.push_back(a.a);
+        }
+        auto isVariant = [&](uint32_t v){ return find(variant.begin(), variant.end(), v) != variant.end(); };
+        bool invariantBound = true;
+        uint32_t nodes = 0;
+        ast.postOrder(cond.b, walk, [&](NodeId id){
+            nodes++;
+            if(ast[id].kind == NodeKind::VAR && isVariant(ast[id].a)) invariantBound = false;
+        });
+        long long bound;
+        if(!invariantBound || !isVariant(iv) || !known[iv] || !evaluate(cond.b, bound)) return false;
+
+        // One iteration, symbolically.
+        ScalarEvolution ev;
+        ev.exact = exact;
+        unordered_map<uint32_t, Poly> end;
+        vector<Poly> stack;
+        bool ok = true;
+        for(uint32_t k = 0; ok && k < count; k++){
+            const Node &a = ast[ast.stmts(body)[k]];
+            ast.postOrder(a.b, walk, [&](NodeId id){
+                const Node &e = ast[id];
+                if(!ok || ++nodes > MAX_CLOSED_FORM_NODES){
+                    ok = false;
+                    return;
+                }
+                if(e.kind == NodeKind::INT) stack.push_back(ev.constant(e.value()));
+                else if(e.kind == NodeKind::VAR){
+                    auto it = end.find(e.a);
+                    if(it != end.end()) stack.push_back(it->second);
+                    else if(isVariant(e.a)) stack.push_back(ev.symbol(e.a));
+                    else if(known[e.a]) stack.push_back(ev.constant(value[e.a]));
+                    else ok = false;
+                } else if(e.kind == NodeKind::ADD || e.kind == NodeKind::SUB){
+                    ok = ev.add(stack[stack.size() - 2], stack.back(), e.kind == NodeKind::SUB);
+                    stack.pop_back();
+                } else if(e.kind == NodeKind::MUL){
+                    Poly r;
+                    ok = ev.mul(stack[stack.size() - 2], stack.back(), r);
+                    stack.pop_back();
+                    stack.back().swap(r);
+                } else ok = false;
+            });
+            if(ok) end[a.a] = move(stack.back());
+            stack.clear();
+        }
+        if(!ok) return false;
+
+        // Solve the variables in dependency order.
+        unordered_map<uint32_t, Rec> rec;               // accumulators, at the start of iteration k
+        vector<pair<uint32_t, Rec>> temporaries;        // at the end of iteration k
+        vector<uint32_t> todo = variant;
+        for(bool progress = true; progress && !todo.empty(); ){
+            progress = false;
+            for(size_t t = 0; t < todo.size(); t++){
+                uint32_t v = todo[t];
+                Poly g = end[v];
+                auto self = g.find({v});
+                bool accumulator = self != g.end() && self->second == 1;
+                if(accumulator) g.erase(self);
+                if(ev.mentions(g, v)) return false;     // x = 2 * x and the like are not polynomial
+                bool ready = true;
+                for(const auto &[m, c] : g)
+                    for(uint32_t slot : m) ready = ready && rec.count(slot);
+                if(!ready) continue;
+                Rec r;
+                if(!ev.substitute(g, rec, r)) return false;
+                if(accumulator){
+                    if(!known[v] || r.size() > ScalarEvolution::MAX_DEGREE) return false;
+                    r.insert(r.begin(), value[v]);
+                    rec[v] = move(r);
+                } else temporaries.push_back({v, move(r)});
+                todo.erase(todo.begin() + t--);
+                progress = true;
+            }
+        }
+        if(!todo.empty() || !rec.count(iv) || rec[iv].size() != 2) return false;
+        uint64_t trips;
+        long long last;
+        if(!tripCount(cond.kind, value[iv], rec[iv][1], bound, trips, last) || trips == 0) return false;
+
+        vector<pair<uint32_t, long long>> finals;
+        for(uint32_t v : variant){
+            long long r;
+            auto it = rec.find(v);
+            if(it != rec.end()){
+                if(!ev.at(it->second, trips, r)) return false;
+            } else {
+                auto tmp = find_if(temporaries.begin(), temporaries.end(), [&](const pair<uint32_t, Rec> &x){ return x.first == v; });
+                if(!ev.at(tmp->second, trips - 1, r)) return false;
+            }
+            finals.push_back({v, r});
+        }
+
+        vector<NodeId> assigns;
+        for(auto [v, r] : finals) assigns.push_back(ast.stmt(NodeKind::ASSIGN, line, v, ast.intLit(r)));
+        uint32_t first = ast.lists.size();
+        ast.lists.insert(ast.lists.end(), assigns.begin(), assigns.end());
+        replace(ast[s], {NodeKind::BLOCK, 0, first, (uint32_t)assigns.size()});
+        if(trace){
+            cout << "[OPTIMIZATION] Closed form: while at line " << line << " runs " << trips << " iterations; replaced by";
+            for(size_t k = 0; k < finals.size(); k++)
+                cout << (k ? ", " : " ") << ast.names.names[finals[k].first] << " = " << finals[k].second;
+            cout << endl;
+        }
+        for(auto [v, r] : finals) set(v, true, r);
+        return true;
+    }
+
+    // Folds expression e in place with the constants known here.
+    void expr(NodeId e){
+        ast.postOrder(e, walk, [&](NodeId id){
+            Node &n = ast[id];
+            if(n.kind == NodeKind::INT || n.kind == NodeKind::BIGLIT){
+                fallible.push_back(0);
+                return;
+            }
+            if(n.kind == NodeKind::VAR){
+                if(known[n.a]){
+                    if(trace) cout << "[OPTIMIZATION] Propagated constant: " << ast.name(id) << " = " << value[n.a] << endl;
+                    long long v = value[n.a];
+                    n = {NodeKind::INT, 0, (uint32_t)(uint64_t)v, (uint32_t)((uint64_t)v >> 32)};
+                }
+                fallible.push_back(0);
+                return;
+            }
+            char bf = fallible.back();
+            fallible.pop_back();
+            char af = fallible.back();
+            foldNode(ast, id, trace, exact);
+            if(n.kind == NodeKind::INT){
+                fallible.back() = 0;
+                return;
+            }
+            const Node A = ast[n.a], B = ast[n.b];
+            auto isInt = [](const Node &x, long long v){ return x.kind == NodeKind::INT && x.value() == v; };
+            const char *rule = nullptr;
+            BinOp op = n.op();
+            if((op == BinOp::ADD && isInt(A, 0)) || (op == BinOp::MUL && isInt(A, 1))){
+                rule = op == BinOp::ADD ? "0 + x = x" : "1 * x = x";
+                n = B;
+                fallible.back() = bf;
+            } else if(((op == BinOp::ADD || op == BinOp::SUB) && isInt(B, 0)) || ((op == BinOp::MUL || op == BinOp::DIV) && isInt(B, 1))){
+                rule = op == BinOp::ADD ? "x + 0 = x" : op == BinOp::SUB ? "x - 0 = x" : op == BinOp::MUL ? "x * 1 = x" : "x / 1 = x";
+                n = A;
+            } else if(op == BinOp::MUL && ((isInt(A, 0) && !bf) || (isInt(B, 0) && !af))){
+                rule = "x * 0 = 0";
+                n = {NodeKind::INT, 0, 0, 0};
+                fallible.back() = 0;
+            } else if(op == BinOp::SUB && A.kind == NodeKind::VAR && B.kind == NodeKind::VAR && A.a == B.a){
+                rule = "x - x = 0";
+                n = {NodeKind::INT, 0, 0, 0};
+                fallible.back() = 0;
+            } else {
+                bool divisorOk = B.kind == NodeKind::INT && B.value() != 0;
+                fallible.back() = af || bf || ((op == BinOp::DIV || op == BinOp::MOD) && !divisorOk);
+            }
+            if(rule && trace) cout << "[OPTIMIZATION] Simplified: " << rule << endl;
+        });
+        fallible.pop_back();
+    }
+
+    // The value of e with the constants known here, without changing it.
+    bool evaluate(NodeId e, long long &r){
+        bool ok = true;
+        ast.postOrder(e, walk, [&](NodeId id){
+            const Node &n = ast[id];
+            if(n.kind == NodeKind::INT) values.push_back(n.value());
+            else if(n.kind == NodeKind::BIGLIT){
+                ok = false;
+                values.push_back(0);
+            } else if(n.kind == NodeKind::VAR){
+                ok = ok && known[n.a];
+                values.push_back(value[n.a]);
+            } else {
+                long long b = values.back();
+                values.pop_back();
+                ok = ok && evalBinOp(n.op(), values.back(), b, values.back(), exact);
+            }
+        });
+        r = values.back();
+        values.pop_back();
+        return ok;
+    }
+
+    // Handles statement s of a block; if, while and nested blocks are pushed
+    // and finished by run().
+    void statement(NodeId s){
+        Node &n = ast[s];
+        switch(n.kind){
+            case NodeKind::ASSIGN: {
+                expr(n.b);
+                const Node &v = ast[n.b];
+                set(n.a, v.kind == NodeKind::INT, v.kind == NodeKind::INT ? v.value() : 0);
+                break;
+            }
+            case NodeKind::PRINT:
+                expr(n.a);
+                break;
+            case NodeKind::IF:
+                expr(n.a);
+                if(ast[n.a].kind == NodeKind::INT){
+                    bool taken = ast[n.a].value() != 0;
+                    if(trace) cout << "[OPTIMIZATION] Removed dead branch: if at line " << n.line << " is always "
+                                   << (taken ? "true" : "false") << endl;
+                    NodeId branch = taken ? n.b : n.c;
+                    if(branch == NO_NODE) makeEmpty(s);
+                    else replace(n, ast[branch]);
+                    if(n.b) open.push_back({s, 0, 0, 0});      // now a plain block
+                    break;
+                }
+                open.push_back({s, 1, undo.size(), thenState.size()});
+                open.push_back({n.b, 0, 0, 0});
+                break;
+            case NodeKind::WHILE: {
+                long long cond;
+                if(evaluate(n.a, cond) && cond == 0){
+                    if(trace) cout << "[OPTIMIZATION] Removed while at line " << n.line << ": condition is false on entry" << endl;
+                    makeEmpty(s);
+                    break;
+                }
+                if(closedForm(s)) break;
+                forgetLoop(s);
+                expr(n.a);
+                open.push_back({s, 1, 0, 0});
+                open.push_back({n.b, 0, 0, 0});
+                break;
+            }
+            case NodeKind::BLOCK:
+                open.push_back({s, 0, 0, 0});
+                break;
+            default:
+                break;
+        }
+    }
+
+    // The then branch of the if on top is done: keep what it left, and undo
+    // it so the else branch starts from the state before the if.
+    void endThen(Pending &p){
+        for(size_t k = p.mark; k < undo.size(); k++){
+            uint32_t slot = undo[k].slot;
+            if(stamp[slot]) continue;
+            stamp[slot] = 1;
+            thenState.push_back({slot, known[slot], value[slot]});
+        }
+        for(size_t k = thenState.size(); k-- > p.then; ) stamp[thenState[k].slot] = 0;
+        for(size_t k = undo.size(); k-- > p.mark; ){
+            known[undo[k].slot] = undo[k].known;
+            value[undo[k].slot] = undo[k].value;
+        }
+        undo.resize(p.mark);
+    }
+
+    // Both branches are done: a variable either of them changed stays known
+    // only if they agree on it.
+    void endIf(Pending &p){
+        size_t elseEnd = undo.size();
+        for(size_t k = p.then; k < thenState.size(); k++){
+            const Undo &t = thenState[k];
+            stamp[t.slot] = 1;
+            if(!(t.known && known[t.slot] && value[t.slot] == t.value)) set(t.slot, false);
+        }
+        for(size_t k = p.mark; k < elseEnd; k++){
+            Undo e = undo[k];               // e.known/e.value: the state before the else branch
+            if(stamp[e.slot]) continue;
+            stamp[e.slot] = 1;
+            if(!(e.known && known[e.slot] && value[e.slot] == e.value)) set(e.slot, false);
+        }
+        for(size_t k = p.then; k < thenState.size(); k++) stamp[thenState[k].slot] = 0;
+        for(size_t k = p.mark; k < elseEnd; k++) stamp[undo[k].slot] = 0;
+        thenState.resize(p.then);
+    }
+
+    // Drops the statements that became empty blocks from a finished block.
+    void compact(NodeId blk){
+        Node &n = ast[blk];
+        NodeId *list = ast.lists.data() + n.a;
+        uint32_t kept = 0;
+        for(uint32_t k = 0; k < n.b; k++){
+            const Node &s = ast[list[k]];
+            if(s.kind == NodeKind::BLOCK && s.b == 0) continue;
+            list[kept++] = list[k];
+        }
+        n.b = kept;
+    }
+
+    // Folds the block root.  Constants stay known across calls, so --stream
+    // keeps one folder for the whole program.
+    void run(NodeId root){
+        if(trace) cout << "[OPTIMIZATION] Starting constant folding..." << endl;
+        size_t slots = ast.names.size();
+        value.resize(slots, 0);
+        known.resize(slots, 0);
+        stamp.resize(slots, 0);
+        kills.clear();
+        loopKills.clear();
+        findLoopKills(root);
+        open.push_back({root, 0, 0, 0});
+        while(!open.empty()){
+            Pending &p = open.back();
+            const Node &n = ast[p.id];
+            if(n.kind == NodeKind::BLOCK){
+                if(p.k < n.b){
+                    statement(ast.stmts(p.id)[p.k++]);
+                    continue;
+                }
+                compact(p.id);
+                open.pop_back();
+            } else if(n.kind == NodeKind::IF){
+                if(p.k == 1){
+                    endThen(p);
+                    p.k = 2;
+                    if(n.c != NO_NODE){
+                        open.push_back({n.c, 0, 0, 0});
+                        continue;
+                    }
+                }
+                endIf(open.back());
+                open.pop_back();
+            } else {                        // WHILE: its body is done
+                forgetLoop(p.id);
+                open.pop_back();
+            }
+        }
+        undo.clear();
+        if(trace) cout << "[OPTIMIZATION] Constant folding completed!" << endl;
+    }
+};
+
+void foldConstantsInBlock(Ast &ast, NodeId blk, bool trace=true, bool exact=false){
+    ConstantFolder folder(ast, trace);
+    folder.exact = exact;
+    folder.run(blk);
+}
+
+// ============================================================================
+// PHASE 4 & 6: INTERMEDIATE CODE GENERATION - Three Address Code
+// ============================================================================
+// Bump allocator: memory is carved out of large chunks and released all at
+// once when the arena dies.
+struct Arena {
+    struct Chunk { Chunk *next; size_t size; };
+    Chunk *head = nullptr;
+    char *ptr = nullptr, *end = nullptr;
+    size_t nextSize;
+
+    explicit Arena(size_t initial = 64 * 1024): nextSize(initial) {}
+    Arena(const Arena&) = delete;
+    Arena &operator=(const Arena&) = delete;
+    Arena(Arena &&o): Arena(){ *this = move(o); }
+    Arena &operator=(Arena &&o){
+        swap(head, o.head); swap(ptr, o.ptr); swap(end, o.end); swap(nextSize, o.nextSize);
+        return *this;
+    }
+    ~Arena(){
+        while(head){ Chunk *n = head->next; ::operator delete(head); head = n; }
+    }
+
+    void *alloc(size_t bytes, size_t align = alignof(max_align_t)){
+        uintptr_t p = (reinterpret_cast<uintptr_t>(ptr) + align - 1) & ~(uintptr_t)(align - 1);
+        if(!ptr || p + bytes > reinterpret_cast<uintptr_t>(end)){
+            size_t size = max(nextSize, bytes + align + sizeof(Chunk));
+            Chunk *c = static_cast<Chunk*>(::operator new(size));
+            c->next = head; c->size = size; head = c;
+            ptr = reinterpret_cast<char*>(c + 1);
+            end = reinterpret_cast<char*>(c) + size;
+            nextSize = size * 2;
+            p = (reinterpret_cast<uintptr_t>(ptr) + align - 1) & ~(uintptr_t)(align - 1);
+        }
+        ptr = reinterpret_cast<char*>(p + bytes);
+        return reinterpret_cast<void*>(p);
+    }
+
+    template<class T> T *allocArray(size_t n){ return static_cast<T*>(alloc(sizeof(T) * max<size_t>(n, 1), alignof(T))); }
+};
+
+// TAC opcodes; ADD..GTE mirror BinOp one-to-one.
+enum class TACOp : uint8_t {
+    ADD, SUB, MUL, DIV, MOD, EQ, NEQ, LT, GT, LTE, GTE,
+    COPY,      // dst = a
+    PRINT,     // print a
+    IFZ,       // if a == 0 jump to target
+    GOTO,      // jump to target
+};
+
+static_assert(static_cast<int>(TACOp::GTE) == static_cast<int>(BinOp::GTE), "TACOp must mirror BinOp");
+
+inline bool isBinaryTAC(TACOp op){ return op <= TACOp::GTE; }
+inline BinOp tacBinOp(TACOp op){ return static_cast<BinOp>(op); }
+
+// Operand id: the top two bits give the kind, the low 30 bits the index
+// (variable slot, temporary number, or index into the constant pool).
+typedef uint32_t TACId;
+
+struct TACProgram {
+    enum Kind : uint32_t { NONE = 0, VAR = 1, TEMP = 2, CONST = 3 };
+    static TACId make(Kind k, uint32_t index){ return (k << 30) | index; }
+    static Kind kind(TACId id){ return static_cast<Kind>(id >> 30); }
+    static uint32_t index(TACId id){ return id & 0x3FFFFFFF; }
+
+    // Instruction stream as parallel arrays.  For IFZ/GOTO, dst holds the
+    // resolved target instruction index (== count for "end of program").
+    Arena arena;
+    TACOp *op = nullptr;
+    TACId *dst = nullptr, *a = nullptr, *b = nullptr;
+    uint32_t count = 0, capacity = 0;
+    long long *consts = nullptr;
+    uint32_t numConsts = 0, constCapacity = 0;
+    uint32_t numTemps = 0;            // temporaries are numbered 1..numTemps
+    const SlotTable *slots = nullptr;
+
+    explicit TACProgram(const SlotTable *st = nullptr): slots(st) {}
+
+    // Grows the arrays inside the arena; generators size them exactly up
+    // front, so this only copies for IR produced by later passes.
+    void reserve(uint32_t instrs, uint32_t nconsts){
+        if(instrs > capacity){
+            TACOp *nop = arena.allocArray<TACOp>(instrs);
+            TACId *nd = arena.allocArray<TACId>(instrs), *na = arena.allocArray<TACId>(instrs), *nb = arena.allocArray<TACId>(instrs);
+            if(count){
+                memcpy(nop, op, count * sizeof(TACOp));
+                memcpy(nd, dst, count * sizeof(TACId));
+                memcpy(na, a, count * sizeof(TACId));
+                memcpy(nb, b, count * sizeof(TACId));
+            }
+            op = nop; dst = nd; a = na; b = nb; capacity = instrs;
+        }
+        if(nconsts > constCapacity){
+            long long *nc = arena.allocArray<long long>(nconsts);
+            if(numConsts) memcpy(nc, consts, numConsts * sizeof(long long));
+            consts = nc; constCapacity = nconsts;
+        }
+    }
+
+    uint32_t emit(TACOp o, TACId d, TACId x = 0, TACId y = 0){
+        if(count == capacity) reserve(max<uint32_t>(16, capacity * 2), constCapacity);
+        op[count] = o; dst[count] = d; a[count] = x; b[count] = y;
+        return count++;
+    }
+
+    TACId constant(long long v){
+        if(numConsts == constCapacity) reserve(capacity, max<uint32_t>(16, constCapacity * 2));
+        consts[numConsts] = v;
+        return make(CONST, numConsts++);
+    }
+    TACId newTemp(){ return make(TEMP, ++numTemps); }
+    static TACId var(int slot){ return make(VAR, slot); }
+
+    bool isJump(uint32_t pc) const { return op[pc]==TACOp::IFZ || op[pc]==TACOp::GOTO; }
+    uint32_t target(uint32_t pc) const { return dst[pc]; }
+    long long constValue(TACId id) const { return consts[index(id)]; }
+
+    // Memory image used by the executors: [variables | t0 t1 .. tN].
+    size_t numVars() const { return slots ? slots->size() : 0; }
+    size_t memIndex(TACId id) const { return kind(id)==VAR ? index(id) : numVars() + index(id); }
+    size_t memSize() const { return numVars() + numTemps + 1; }
+
+    string operandText(TACId id) const {
+        switch(kind(id)){
+            case VAR:   return slots->names[index(id)];
+            case TEMP:  return string("t") + to_string(index(id));
+            case CONST: return to_string(constValue(id));
+            default:    return "_";
+        }
+    }
+
+    string instrText(uint32_t pc) const {
+        switch(op[pc]){
+            case TACOp::COPY:  return operandText(dst[pc]) + " = " + operandText(a[pc]);
+            case TACOp::PRINT: return "print " + operandText(a[pc]);
+            case TACOp::IFZ:   return "ifz " + operandText(a[pc]) + " goto L" + to_string(dst[pc]);
+            case TACOp::GOTO:  return "goto L" + to_string(dst[pc]);
+            default:
+                return operandText(dst[pc]) + " = " + operandText(a[pc]) + " " +
+                       binOpText(tacBinOp(op[pc])) + " " + operandText(b[pc]);
+        }
+    }
+
+    // Textual listing; jump targets get an "L<index>:" label line.
+    void print(ostream &out) const {
+        vector<bool> isTarget(count + 1, false);
+        for(uint32_t pc = 0; pc < count; pc++) if(isJump(pc)) isTarget[target(pc)] = true;
+        for(uint32_t pc = 0; pc <= count; pc++){
+            if(isTarget[pc]) out << "L" << pc << ":\n";
+            if(pc < count) out << instrText(pc) << "\n";
+        }
+    }
+};
+
+struct TACGen {
+    TACProgram prog;
+    const Ast *ast = nullptr;
+    bool debug;
+    
+    vector<NodeId> walk;
+    vector<TACId> values;      // operands of the expression being generated
+    // Blocks being generated, and the if/while statements around them,
+    // innermost last; `jump` is the branch still waiting for its target.
+    struct Pending { NodeId id; uint32_t k, jump, top; };
+    vector<Pending> open;
+    
+    TACGen(const SlotTable &st, bool dbg=false): prog(&st), debug(dbg) {}
+    
+    // Exact instruction and constant counts, so the IR is allocated once.
+    static void count(const Ast &ast, NodeId root, uint32_t &instrs, uint32_t &consts){
+        vector<NodeId> walk;
+        ast.postOrder(root, walk, [&](NodeId id){
+            const Node &n = ast[id];
+            if(n.kind==NodeKind::INT) consts++;
+            else if(n.isBinary() || n.kind==NodeKind::ASSIGN || n.kind==NodeKind::PRINT) instrs++;
+            else if(n.kind==NodeKind::IF || n.kind==NodeKind::WHILE) instrs += 2;
+        });
+    }
+    
+    uint32_t emit(TACOp op, TACId d, TACId a=0, TACId b=0){
+        uint32_t pc = prog.emit(op, d, a, b);
+        if(debug && !prog.isJump(pc)) cout << "[TAC] Generated: " << prog.instrText(pc) << endl;
+        return pc;
+    }
+    
+    void patch(uint32_t jump, uint32_t target){
+        prog.dst[jump] = target;
+        if(debug) cout << "[TAC] Generated: " << prog.instrText(jump) << endl;
+    }
+    
+    TACId genExpr(NodeId e){
+        ast->postOrder(e, walk, [&](NodeId id){
+            const Node &n = (*ast)[id];
+            if(n.kind==NodeKind::INT){
+                values.push_back(prog.constant(n.value()));
+            } else if(n.kind==NodeKind::VAR){
+                values.push_back(TACProgram::var(n.a));
+            } else if(n.isBinary()){
+                TACId B = values.back();
+                values.pop_back();
+                TACId A = values.back();
+                TACId t = prog.newTemp(); 
+                if(debug) cout << "[TAC] New temporary: " << prog.operandText(t) << endl;
+                emit(static_cast<TACOp>(n.op()), t, A, B);
+                values.back() = t;
+            } else {
+                errs()<<"[TAC ERROR] Unhandled expression type\n"; 
+                fail();
+            }
+        });
+        TACId r = values.back();
+        values.pop_back();
+        return r;
+    }
+    
+    void openBlock(NodeId blk){
+        if(debug) cout << "[TAC] Generating code for block with " << (*ast)[blk].b << " statements" << endl;
+        open.push_back({blk, 0, 0, 0});
+    }
+    
+    // Straight-line statements are generated at once; an if or while emits
+    // its condition and branch, and is finished by genBlock once its blocks are.
+    void genStmt(NodeId s){
+        const Node &n = (*ast)[s];
+        if(n.kind==NodeKind::ASSIGN){
+            TACId r = genExpr(n.b); 
+            emit(TACOp::COPY, TACProgram::var(n.a), r);
+        } else if(n.kind==NodeKind::PRINT){
+            TACId r = genExpr(n.a); 
+            emit(TACOp::PRINT, 0, r);
+        } else if(n.kind==NodeKind::IF){
+            TACId c = genExpr(n.a); 
+            uint32_t jElse = emit(TACOp::IFZ, 0, c);
+            open.push_back({s, 0, jElse, 0});
+            openBlock(n.b);
+        } else if(n.kind==NodeKind::WHILE){
+            uint32_t top = prog.count;
+            TACId c = genExpr(n.a); 
+            uint32_t jExit = emit(TACOp::IFZ, 0, c);
+            open.push_back({s, 0, jExit, top});
+            openBlock(n.b);
+        } else if(n.kind==NodeKind::BLOCK){
+            openBlock(s);
+        } else {
+            errs()<<"[TAC ERROR] Unknown statement type\n"; 
+            fail();
+        }
+    }
+    
+    void genBlock(NodeId root){
+        openBlock(root);
+        while(!open.empty()){
+            Pending &p = open.back();
+            const Node &n = (*ast)[p.id];
+            if(n.kind==NodeKind::BLOCK){
+                if(p.k == n.b) open.pop_back();
+                else genStmt(ast->stmts(p.id)[p.k++]);
+            } else if(n.kind==NodeKind::IF){
+                if(p.k++ == 0){
+                    // then block done: jump over the else part
+                    uint32_t jEnd = emit(TACOp::GOTO, 0);
+                    patch(p.jump, prog.count);
+                    p.jump = jEnd;
+                    if(n.c != NO_NODE){
+                        openBlock(n.c);
+                        continue;
+                    }
+                }
+                patch(p.jump, prog.count);
+                open.pop_back();
+            } else {
+                // while body done: back to the condition
+                patch(emit(TACOp::GOTO, 0), p.top);
+                patch(p.jump, prog.count);
+                open.pop_back();
+            }
+        }
+    }
+    
+    void genProgram(const Ast &tree){
+        ast = &tree;
+        uint32_t instrs = 0, consts = 0;
+        count(tree, tree.root, instrs, consts);
+        prog.reserve(instrs, consts);
+        genBlock(tree.root);
+    }
+};
+
+// ============================================================================
+// PHASE 5: OPTIMIZATION - SSA Pass Pipeline over TAC
+// ============================================================================
+// The TAC is split into basic blocks at jump targets and after jumps, put
+// into SSA form (semi-pruned phis on the iterated dominance frontier) and
+// run through SCCP, copy propagation, GVN and DCE.  Lowering back to TAC
+// keeps the original block order and gives every phi its variable's slot
+// unless it interferes with another version of the same variable.
+struct SSAValue {
+    enum Kind : uint8_t { UNDEF, CONST, PHI, INSTR } kind;
+    int var = -1;          // PHI: the variable slot it merges
+    long long c = 0;       // CONST: the value
+};
+
+struct SSAInstr {
+    TACOp op;              // ADD..GTE, COPY or PRINT
+    int def = -1;          // value defined here (-1 for PRINT)
+    int a = -1, b = -1;    // operand values
+};
+
+struct SSAPhi {
+    int def, var;
+    vector<int> args;      // parallel to the block's preds
+};
+
+struct SSABlock {
+    vector<int> preds;
+    vector<int> succs;     // with a cond: succs[0] when cond != 0, succs[1] when cond == 0
+    vector<SSAPhi> phis;
+    vector<SSAInstr> code;
+    int cond = -1;
+    uint32_t start = 0, end = 0;   // source TAC range [start, end)
+    bool dead = false;
+    bool leading = false;          // laid out ahead of the block sharing its start
+};
+
+struct SSAFunction {
+    static constexpr int ENTRY = 0, EXIT = 1;
+    vector<SSABlock> blocks;
+    vector<SSAValue> values;       // value 0 is the shared UNDEF
+    vector<int> repl;              // pending "replace value by" links, -1 = none
+    map<long long,int> constValues;
+    size_t numVars = 0;
+    vector<int> idom, rpo;
+    vector<vector<int>> domChildren;
+    bool debug = false;
+
+    int newValue(SSAValue::Kind k, int var = -1){
+        values.push_back({k, var, 0});
+        repl.push_back(-1);
+        return values.size() - 1;
+    }
+    int constant(long long c){
+        auto it = constValues.find(c);
+        if(it != constValues.end()) return it->second;
+        int v = newValue(SSAValue::CONST);
+        values[v].c = c;
+        constValues[c] = v;
+        return v;
+    }
+    int resolve(int v){
+        if(v < 0) return v;
+        int r = v;
+        while(repl[r] >= 0) r = repl[r];
+        while(repl[v] >= 0){ int n = repl[v]; repl[v] = r; v = n; }
+        return r;
+    }
+    bool isConst(int v) const { return v >= 0 && values[v].kind==SSAValue::CONST; }
+
+    size_t instructionCount() const {
+        size_t n = 0;
+        for(auto &b : blocks) if(!b.dead) n += b.code.size() + b.phis.size() + (b.cond >= 0);
+        return n;
+    }
+
+    // ---- CFG --------------------------------------------------------------
+    void removeEdge(int from, int to){
+        SSABlock &t = blocks[to];
+        for(size_t i = 0; i < t.preds.size(); i++) if(t.preds[i]==from){
+            t.preds.erase(t.preds.begin() + i);
+            for(auto &p : t.phis) p.args.erase(p.args.begin() + i);
+            break;
+        }
+        SSABlock &f = blocks[from];
+        for(size_t i = 0; i < f.succs.size(); i++) if(f.succs[i]==to){
+            f.succs.erase(f.succs.begin() + i);
+            break;
+        }
+        if(f.succs.size() < 2) f.cond = -1;
+    }
+
+    void killBlock(int b){
+        while(!blocks[b].succs.empty()) removeEdge(b, blocks[b].succs.back());
+        while(!blocks[b].preds.empty()) removeEdge(blocks[b].preds.back(), b);
+        blocks[b].phis.clear();
+        blocks[b].code.clear();
+        blocks[b].dead = true;
+    }
+
+    void computeRPO(){
+        rpo.clear();
+        vector<char> seen(blocks.size(), 0);
+        vector<pair<int,size_t>> stack{{ENTRY, 0}};
+        seen[ENTRY] = 1;
+        while(!stack.empty()){
+            auto &top = stack.back();
+            if(top.second < blocks[top.first].succs.size()){
+                int s = blocks[top.first].succs[top.second++];
+                if(!seen[s]){ seen[s] = 1; stack.push_back({s, 0}); }
+            } else {
+                rpo.push_back(top.first);
+                stack.pop_back();
+            }
+        }
+        reverse(rpo.begin(), rpo.end());
+        for(size_t b = 0; b < blocks.size(); b++) if(!seen[b] && !blocks[b].dead) killBlock(b);
+    }
+
+    // Cooper-Harvey-Kennedy iterative dominators over the reverse postorder.
+    void computeDominators(){
+        computeRPO();
+        vector<int> order(blocks.size(), -1);
+        for(size_t i = 0; i < rpo.size(); i++) order[rpo[i]] = i;
+        idom.assign(blocks.size(), -1);
+        idom[ENTRY] = ENTRY;
+        bool changed = true;
+        while(changed){
+            changed = false;
+            for(size_t i = 1; i < rpo.size(); i++){
+                int b = rpo[i], nd = -1;
+                for(int p : blocks[b].preds){
+                    if(idom[p] < 0) continue;
+                    if(nd < 0){ nd = p; continue; }
+                    int x = p, y = nd;
+                    while(x != y){
+                        while(order[x] > order[y]) x = idom[x];
+                        while(order[y] > order[x]) y = idom[y];
+                    }
+                    nd = x;
+                }
+                if(nd != idom[b]){ idom[b] = nd; changed = true; }
+            }
+        }
+        domChildren.assign(blocks.size(), {});
+        for(int b : rpo) if(b != ENTRY) domChildren[idom[b]].push_back(b);
+    }
+
+    // Visits the dominator tree in preorder, calling leave(b) once all of
+    // b's subtree is done; iterative so deep nesting cannot overflow.
+    template<class Enter, class Leave> void walkDomTree(Enter enter, Leave leave){
+        vector<pair<int,size_t>> stack{{ENTRY, 0}};
+        enter(ENTRY);
+        while(!stack.empty()){
+            auto &top = stack.back();
+            if(top.second < domChildren[top.first].size()){
+                int c = domChildren[top.first][top.second++];
+                enter(c);
+                stack.push_back({c, 0});
+            } else {
+                leave(top.first);
+                stack.pop_back();
+            }
+        }
+    }
+
+    // ---- Construction -----------------------------------------------------
+    void build(const TACProgram &tac){
+        numVars = tac.numVars();
+        newValue(SSAValue::UNDEF);
+        vector<char> leader(tac.count + 1, 0);
+        leader[0] = 1;
+        for(uint32_t pc = 0; pc < tac.count; pc++) if(tac.isJump(pc)){
+            leader[tac.target(pc)] = 1;
+            leader[pc + 1] = 1;
+        }
+        blocks.resize(2);
+        vector<int> blockAt(tac.count + 1, EXIT);
+        for(uint32_t pc = 0; pc < tac.count; pc++) if(leader[pc]){
+            blockAt[pc] = blocks.size();
+            blocks.push_back({});
+            blocks.back().start = pc;
+        }
+        for(size_t b = 2; b < blocks.size(); b++)
+            blocks[b].end = b + 1 < blocks.size() ? blocks[b+1].start : tac.count;
+        blocks[EXIT].start = blocks[EXIT].end = tac.count;
+        auto addEdge = [&](int from, int to){
+            blocks[from].succs.push_back(to);
+            blocks[to].preds.push_back(from);
+        };
+        addEdge(ENTRY, tac.count ? blockAt[0] : EXIT);
+        for(size_t b = 2; b < blocks.size(); b++){
+            uint32_t last = blocks[b].end - 1;
+            int next = blockAt[blocks[b].end];
+            if(tac.op[last]==TACOp::GOTO) addEdge(b, blockAt[tac.target(last)]);
+            else if(tac.op[last]==TACOp::IFZ && blockAt[tac.target(last)] != next){
+                addEdge(b, next);
+                addEdge(b, blockAt[tac.target(last)]);
+            } else addEdge(b, next);
+        }
+        computeDominators();
+
+        // Semi-pruned phi placement: only variables read before being
+        // written in some block can need a phi.
+        vector<vector<int>> defSites(numVars);
+        vector<char> global(numVars, 0);
+        for(int b : rpo){
+            vector<char> killed(numVars, 0);
+            for(uint32_t pc = blocks[b].start; pc < blocks[b].end; pc++){
+                auto use = [&](TACId id){
+                    if(TACProgram::kind(id)==TACProgram::VAR && !killed[TACProgram::index(id)]) global[TACProgram::index(id)] = 1;
+                };
+                if(tac.op[pc]==TACOp::GOTO) continue;
+                use(tac.a[pc]);
+                if(isBinaryTAC(tac.op[pc])) use(tac.b[pc]);
+                if((isBinaryTAC(tac.op[pc]) || tac.op[pc]==TACOp::COPY) && TACProgram::kind(tac.dst[pc])==TACProgram::VAR){
+                    uint32_t v = TACProgram::index(tac.dst[pc]);
+                    if(!killed[v]){ killed[v] = 1; defSites[v].push_back(b); }
+                }
+            }
+        }
+        vector<vector<int>> frontier(blocks.size());
+        for(int b : rpo){
+            if(blocks[b].preds.size() < 2) continue;
+            for(int p : blocks[b].preds){
+                int runner = p;
+                while(runner != idom[b]){
+                    if(frontier[runner].empty() || frontier[runner].back() != b) frontier[runner].push_back(b);
+                    runner = idom[runner];
+                }
+            }
+        }
+        vector<int> hasPhi(blocks.size(), -1);
+        for(size_t v = 0; v < numVars; v++){
+            if(!global[v]) continue;
+            vector<int> work = defSites[v];
+            vector<char> queued(blocks.size(), 0);
+            for(int b : work) queued[b] = 1;
+            while(!work.empty()){
+                int b = work.back(); work.pop_back();
+                for(int f : frontier[b]){
+                    if(hasPhi[f] == (int)v) continue;
+                    hasPhi[f] = v;
+                    int d = newValue(SSAValue::PHI, v);
+                    blocks[f].phis.push_back({d, (int)v, vector<int>(blocks[f].preds.size(), 0)});
+                    if(!queued[f]){ queued[f] = 1; work.push_back(f); }
+                }
+            }
+        }
+
+        // Renaming along the dominator tree with an undo log.
+        vector<int> current(numVars, 0);
+        vector<int> tempValue(tac.numTemps + 1, 0);
+        vector<pair<int,int>> undo;
+        vector<size_t> mark(blocks.size(), 0);
+        auto operand = [&](TACId id){
+            switch(TACProgram::kind(id)){
+                case TACProgram::VAR:  return current[TACProgram::index(id)];
+                case TACProgram::TEMP: return tempValue[TACProgram::index(id)];
+                case TACProgram::CONST: return constant(tac.constValue(id));
+                default: return 0;
+            }
+        };
+        auto define = [&](TACId id, int value){
+            if(TACProgram::kind(id)==TACProgram::VAR){
+                undo.push_back({(int)TACProgram::index(id), current[TACProgram::index(id)]});
+                current[TACProgram::index(id)] = value;
+            } else tempValue[TACProgram::index(id)] = value;
+        };
+        walkDomTree([&](int b){
+            SSABlock &blk = blocks[b];
+            mark[b] = undo.size();
+            for(auto &p : blk.phis){ undo.push_back({p.var, current[p.var]}); current[p.var] = p.def; }
+            for(uint32_t pc = blk.start; pc < blk.end; pc++){
+                TACOp op = tac.op[pc];
+                if(op==TACOp::GOTO) continue;
+                if(op==TACOp::IFZ){
+                    if(blk.succs.size()==2) blk.cond = operand(tac.a[pc]);
+                    continue;
+                }
+                SSAInstr in{op, -1, operand(tac.a[pc]), isBinaryTAC(op) ? operand(tac.b[pc]) : -1};
+                if(op != TACOp::PRINT){
+                    in.def = newValue(SSAValue::INSTR);
+                    define(tac.dst[pc], in.def);
+                }
+                blk.code.push_back(in);
+            }
+            for(int s : blk.succs){
+                size_t j = find(blocks[s].preds.begin(), blocks[s].preds.end(), b) - blocks[s].preds.begin();
+                for(auto &p : blocks[s].phis) p.args[j] = current[p.var];
+            }
+        }, [&](int b){
+            while(undo.size() > mark[b]){ current[undo.back().first] = undo.back().second; undo.pop_back(); }
+        });
+    }
+
+    // Rewrites every operand through the pending replacement links.
+    void applyReplacements(){
+        for(auto &b : blocks){
+            if(b.dead) continue;
+            for(auto &p : b.phis) for(auto &a : p.args) a = resolve(a);
+            for(auto &in : b.code){ in.a = resolve(in.a); in.b = resolve(in.b); }
+            b.cond = resolve(b.cond);
+        }
+    }
+
+    void dump(ostream &out){
+        auto name = [&](int v){
+            if(v < 0) return string("_");
+            if(values[v].kind==SSAValue::CONST) return to_string(values[v].c);
+            if(values[v].kind==SSAValue::UNDEF) return string("undef");
+            return "%" + to_string(v);
+        };
+        for(size_t b = 0; b < blocks.size(); b++){
+            if(blocks[b].dead) continue;
+            out << "B" << b << " preds(";
+            for(int p : blocks[b].preds) out << " B" << p;
+            out << " ) idom B" << (idom.size() > b ? idom[b] : -1) << "\n";
+            for(auto &p : blocks[b].phis){
+                out << "  " << name(p.def) << " = phi";
+                for(int a : p.args) out << " " << name(a);
+                out << "\n";
+            }
+            for(auto &in : blocks[b].code){
+                if(in.op==TACOp::PRINT) out << "  print " << name(in.a) << "\n";
+                else if(in.op==TACOp::COPY) out << "  " << name(in.def) << " = " << name(in.a) << "\n";
+                else out << "  " << name(in.def) << " = " << name(in.a) << " " << binOpText(tacBinOp(in.op)) << " " << name(in.b) << "\n";
+            }
+            if(blocks[b].cond >= 0) out << "  br " << name(blocks[b].cond) << " B" << blocks[b].succs[0] << " B" << blocks[b].succs[1] << "\n";
+            else if(!blocks[b].succs.empty()) out << "  jmp B" << blocks[b].succs[0] << "\n";
+        }
+    }
+};
+
+// Sparse conditional constant propagation (Wegman-Zadeck): values start at
+// TOP and only CFG edges proven executable are followed.
+void ssaSCCP(SSAFunction &f){
+    enum : uint8_t { TOP, CONSTANT, BOTTOM };
+    size_t nv = f.values.size();
+    vector<uint8_t> lat(nv, TOP);
+    vector<long long> val(nv, 0);
+    for(size_t v = 0; v < nv; v++) if(f.values[v].kind==SSAValue::CONST){ lat[v] = CONSTANT; val[v] = f.values[v].c; }
+    lat[0] = BOTTOM;   // a read of a never-assigned variable is not a constant
+
+    // Def-use chains as (block, index) with index -1-k for phi k and
+    // INT_MAX for the block's branch condition.
+    vector<vector<pair<int,int>>> users(nv);
+    for(size_t b = 0; b < f.blocks.size(); b++){
+        auto &blk = f.blocks[b];
+        if(blk.dead) continue;
+        for(size_t k = 0; k < blk.phis.size(); k++) for(int a : blk.phis[k].args) users[a].push_back({(int)b, -1 - (int)k});
+        for(size_t k = 0; k < blk.code.size(); k++){
+            if(blk.code[k].a >= 0) users[blk.code[k].a].push_back({(int)b, (int)k});
+            if(blk.code[k].b >= 0) users[blk.code[k].b].push_back({(int)b, (int)k});
+        }
+        if(blk.cond >= 0) users[blk.cond].push_back({(int)b, INT_MAX});
+    }
+
+    vector<char> blockExec(f.blocks.size(), 0);
+    vector<vector<char>> edgeExec(f.blocks.size());
+    for(size_t b = 0; b < f.blocks.size(); b++) edgeExec[b].assign(f.blocks[b].preds.size(), 0);
+    vector<pair<int,int>> flowWork{{-1, SSAFunction::ENTRY}};
+    vector<int> ssaWork;
+
+    auto lower = [&](int v, uint8_t l, long long c){
+        if(l <= lat[v]) return;
+        lat[v] = l; val[v] = c;
+        ssaWork.push_back(v);
+    };
+    auto visitPhi = [&](int b, SSAPhi &p){
+        uint8_t l = TOP; long long c = 0;
+        for(size_t i = 0; i < p.args.size(); i++){
+            if(!edgeExec[b][i]) continue;
+            int a = p.args[i];
+            if(lat[a]==TOP) continue;
+            if(lat[a]==BOTTOM || (l==CONSTANT && val[a] != c)){ l = BOTTOM; break; }
+            l = CONSTANT; c = val[a];
+        }
+        lower(p.def, l, c);
+    };
+    auto visitInstr = [&](SSAInstr &in){
+        if(in.op==TACOp::PRINT) return;
+        if(in.op==TACOp::COPY){ lower(in.def, lat[in.a], val[in.a]); return; }
+        if(lat[in.a]==BOTTOM || lat[in.b]==BOTTOM){ lower(in.def, BOTTOM, 0); return; }
+        if(lat[in.a]==TOP || lat[in.b]==TOP) return;
+        long long r;
+        if(evalBinOp(tacBinOp(in.op), val[in.a], val[in.b], r)) lower(in.def, CONSTANT, r);
+        else lower(in.def, BOTTOM, 0);
+    };
+    auto visitBranch = [&](int b){
+        auto &blk = f.blocks[b];
+        if(blk.cond < 0){ for(int s : blk.succs) flowWork.push_back({b, s}); return; }
+        if(lat[blk.cond]==TOP) return;
+        if(lat[blk.cond]==CONSTANT) flowWork.push_back({b, blk.succs[val[blk.cond] ? 0 : 1]});
+        else { flowWork.push_back({b, blk.succs[0]}); flowWork.push_back({b, blk.succs[1]}); }
+    };
+
+    while(!flowWork.empty() || !ssaWork.empty()){
+        while(!flowWork.empty()){
+            auto e = flowWork.back(); flowWork.pop_back();
+            int b = e.second;
+            if(e.first >= 0){
+                size_t i = find(f.blocks[b].preds.begin(), f.blocks[b].preds.end(), e.first) - f.blocks[b].preds.begin();
+                if(edgeExec[b][i]) continue;
+                edgeExec[b][i] = 1;
+            }
+            for(auto &p : f.blocks[b].phis) visitPhi(b, p);
+            if(!blockExec[b]){
+                blockExec[b] = 1;
+                for(auto &in : f.blocks[b].code) visitInstr(in);
+                visitBranch(b);
+            }
+        }
+        while(!ssaWork.empty()){
+            int v = ssaWork.back(); ssaWork.pop_back();
+            for(auto &u : users[v]){
+                if(!blockExec[u.first]) continue;
+                auto &blk = f.blocks[u.first];
+                if(u.second==INT_MAX) visitBranch(u.first);
+                else if(u.second < 0) visitPhi(u.first, blk.phis[-1 - u.second]);
+                else visitInstr(blk.code[u.second]);
+            }
+        }
+    }
+
+    // Drop never-taken edges and unreachable blocks, then replace every
+    // constant value by its literal and delete its definition.
+    vector<pair<int,int>> deadEdges;
+    for(size_t b = 0; b < f.blocks.size(); b++)
+        for(size_t i = 0; i < f.blocks[b].preds.size(); i++)
+            if(!edgeExec[b][i]) deadEdges.push_back({f.blocks[b].preds[i], (int)b});
+    for(auto &e : deadEdges) f.removeEdge(e.first, e.second);
+    for(size_t b = 0; b < f.blocks.size(); b++)
+        if(!f.blocks[b].dead && !blockExec[b]) f.killBlock(b);
+    for(auto &blk : f.blocks){
+        if(blk.dead) continue;
+        auto keepPhi = [&](SSAPhi &p){
+            if(lat[p.def]!=CONSTANT) return true;
+            f.repl[p.def] = f.constant(val[p.def]);
+            return false;
+        };
+        blk.phis.erase(remove_if(blk.phis.begin(), blk.phis.end(), [&](SSAPhi &p){ return !keepPhi(p); }), blk.phis.end());
+        blk.code.erase(remove_if(blk.code.begin(), blk.code.end(), [&](SSAInstr &in){
+            if(in.def < 0 || lat[in.def]!=CONSTANT) return false;
+            f.repl[in.def] = f.constant(val[in.def]);
+            return true;
+        }), blk.code.end());
+    }
+    f.applyReplacements();
+}
+
+// Copy propagation: uses of a copy read its source directly, and phis whose
+// incoming values are all the same (ignoring self-references) disappear.
+void ssaCopyPropagation(SSAFunction &f){
+    for(auto &blk : f.blocks){
+        if(blk.dead) continue;
+        blk.code.erase(remove_if(blk.code.begin(), blk.code.end(), [&](SSAInstr &in){
+            if(in.op!=TACOp::COPY) return false;
+            f.repl[in.def] = f.resolve(in.a);
+            return true;
+        }), blk.code.end());
+    }
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(auto &blk : f.blocks){
+            if(blk.dead) continue;
+            blk.phis.erase(remove_if(blk.phis.begin(), blk.phis.end(), [&](SSAPhi &p){
+                int same = -1;
+                for(int a : p.args){
+                    a = f.resolve(a);
+                    if(a==p.def || a==same) continue;
+                    if(same >= 0) return false;
+                    same = a;
+                }
+                f.repl[p.def] = same < 0 ? 0 : same;
+                changed = true;
+                return true;
+            }), blk.phis.end());
+        }
+    }
+    f.applyReplacements();
+}
+
+// Dominator-scoped global value numbering: an expression already computed
+// in a dominating block is reused instead of recomputed.
+void ssaGVN(SSAFunction &f){
+    f.computeDominators();
+    struct Key {
+        TACOp op; int a, b;
+        bool operator==(const Key &o) const { return op==o.op && a==o.a && b==o.b; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &k) const { return ((size_t)k.op * 1000003u) ^ ((size_t)k.a * 7919u) ^ (size_t)k.b; }
+    };
+    unordered_map<Key,int,KeyHash> table;
+    vector<Key> log;
+    vector<size_t> mark(f.blocks.size(), 0);
+    f.walkDomTree([&](int b){
+        mark[b] = log.size();
+        auto &code = f.blocks[b].code;
+        code.erase(remove_if(code.begin(), code.end(), [&](SSAInstr &in){
+            if(!isBinaryTAC(in.op)) return false;
+            in.a = f.resolve(in.a); in.b = f.resolve(in.b);
+            Key k{in.op, in.a, in.b};
+            bool commutative = in.op==TACOp::ADD || in.op==TACOp::MUL || in.op==TACOp::EQ || in.op==TACOp::NEQ;
+            if(commutative && k.a > k.b) swap(k.a, k.b);
+            auto it = table.find(k);
+            if(it != table.end()){ f.repl[in.def] = it->second; return true; }
+            table[k] = in.def;
+            log.push_back(k);
+            return false;
+        }), code.end());
+    }, [&](int b){
+        while(log.size() > mark[b]){ table.erase(log.back()); log.pop_back(); }
+    });
+    f.applyReplacements();
+}
+
+// A natural loop: the header, its single back-edge source and the member
+// blocks; `preheader` is the header's only predecessor outside the loop.
+struct SSALoop {
+    int header, latch, preheader = -1;
+    vector<char> body;
+    size_t size = 0;
+};
+
+// Gives the loop a dedicated preheader; outside predecessors are routed
+// through a new block, merging their phi arguments there if they differ.
+void ensurePreheader(SSAFunction &f, SSALoop &loop){
+    int h = loop.header;
+    loop.body.resize(f.blocks.size(), 0);
+    vector<int> outside;
+    for(int p : f.blocks[h].preds) if(!loop.body[p]) outside.push_back(p);
+    if(outside.size()==1 && f.blocks[outside[0]].succs.size()==1){ loop.preheader = outside[0]; return; }
+
+    int n = f.blocks.size();
+    f.blocks.push_back({});
+    f.blocks[n].start = f.blocks[h].start;
+    f.blocks[n].leading = true;
+    f.blocks[n].preds = outside;
+    f.blocks[n].succs = {h};
+    for(int o : outside) for(int &s : f.blocks[o].succs) if(s==h) s = n;
+
+    SSABlock &hb = f.blocks[h];
+    vector<int> preds;
+    vector<size_t> inside, outsideAt;
+    for(size_t i = 0; i < hb.preds.size(); i++) (loop.body[hb.preds[i]] ? inside : outsideAt).push_back(i);
+    for(size_t i : inside) preds.push_back(hb.preds[i]);
+    preds.push_back(n);
+    for(auto &p : hb.phis){
+        vector<int> args, merged;
+        for(size_t i : inside) args.push_back(p.args[i]);
+        for(size_t i : outsideAt) merged.push_back(p.args[i]);
+        int v = merged[0];
+        if(any_of(merged.begin(), merged.end(), [&](int a){ return a != merged[0]; })){
+            v = f.newValue(SSAValue::PHI, p.var);
+            f.blocks[n].phis.push_back({v, p.var, merged});
+        }
+        args.push_back(v);
+        p.args = args;
+    }
+    f.blocks[h].preds = preds;
+    loop.preheader = n;
+    loop.body.resize(f.blocks.size(), 0);
+}
+
+// Finds every natural loop (one per back edge), gives each a preheader and
+// returns them innermost first.  Dominators are current afterwards.
+vector<SSALoop> findLoops(SSAFunction &f){
+    f.computeDominators();
+    // a dominates b iff b's dominator-tree interval lies within a's; walking
+    // the idom chain instead would be quadratic for deeply nested code.
+    vector<int> first(f.blocks.size(), -1), last(f.blocks.size(), -1);
+    int clock = 0;
+    f.walkDomTree([&](int b){ first[b] = clock++; }, [&](int b){ last[b] = clock++; });
+    auto dominates = [&](int a, int b){
+        return first[a] >= 0 && first[b] >= 0 && first[a] <= first[b] && last[b] <= last[a];
+    };
+    vector<SSALoop> loops;
+    for(int b : f.rpo) for(int s : f.blocks[b].succs){
+        if(!dominates(s, b)) continue;
+        SSALoop loop;
+        loop.header = s; loop.latch = b;
+        loop.body.assign(f.blocks.size(), 0);
+        loop.body[s] = 1;
+        vector<int> work;
+        if(!loop.body[b]){ loop.body[b] = 1; work.push_back(b); }
+        while(!work.empty()){
+            int x = work.back(); work.pop_back();
+            for(int p : f.blocks[x].preds) if(!loop.body[p]){ loop.body[p] = 1; work.push_back(p); }
+        }
+        loop.size = count(loop.body.begin(), loop.body.end(), 1);
+        loops.push_back(loop);
+    }
+    // Two back edges into one header would need a merged latch; such loops
+    // cannot come out of `while`, so they are left alone.
+    map<int,int> perHeader;
+    for(auto &l : loops) perHeader[l.header]++;
+    loops.erase(remove_if(loops.begin(), loops.end(), [&](SSALoop &l){ return perHeader[l.header] > 1; }), loops.end());
+    size_t original = f.blocks.size();
+    for(auto &l : loops) ensurePreheader(f, l);
+    for(auto &l : loops){
+        l.body.resize(f.blocks.size(), 0);
+        // A new preheader of a nested loop belongs to the enclosing loop.
+        for(auto &m : loops)
+            if(m.header != l.header && l.body[m.header] && (size_t)m.preheader >= original) l.body[m.preheader] = 1;
+        l.size = count(l.body.begin(), l.body.end(), 1);
+    }
+    f.computeDominators();
+    stable_sort(loops.begin(), loops.end(), [](const SSALoop &x, const SSALoop &y){ return x.size < y.size; });
+    return loops;
+}
+
+// Block that defines each value (-1 for constants and undef).
+vector<int> defBlocks(SSAFunction &f){
+    vector<int> at(f.values.size(), -1);
+    for(size_t b = 0; b < f.blocks.size(); b++){
+        if(f.blocks[b].dead) continue;
+        for(auto &p : f.blocks[b].phis) at[p.def] = b;
+        for(auto &in : f.blocks[b].code) if(in.def >= 0) at[in.def] = b;
+    }
+    return at;
+}
+
+// Loop-invariant code motion: arithmetic whose operands are all defined
+// outside the loop moves to the preheader.  Inner loops go first, so an
+// expression can climb several levels.  Divisions that may trap stay put.
+size_t ssaLICM(SSAFunction &f){
+    vector<SSALoop> loops = findLoops(f);
+    vector<int> defAt = defBlocks(f);
+    size_t hoisted = 0;
+    for(auto &loop : loops){
+        auto invariant = [&](int v){ return v < 0 || (size_t)v >= defAt.size() || defAt[v] < 0 || !loop.body[defAt[v]]; };
+        auto &pre = f.blocks[loop.preheader].code;
+        for(int b : f.rpo){
+            if(!loop.body[b]) continue;
+            auto &code = f.blocks[b].code;
+            code.erase(remove_if(code.begin(), code.end(), [&](SSAInstr &in){
+                if(!isBinaryTAC(in.op) || !invariant(in.a) || !invariant(in.b)) return false;
+                if((in.op==TACOp::DIV || in.op==TACOp::MOD) &&
+                   (!f.isConst(in.b) || f.values[in.b].c==0 || f.values[in.b].c==-1)) return false;
+                pre.push_back(in);
+                defAt[in.def] = loop.preheader;
+                hoisted++;
+                return true;
+            }), code.end());
+        }
+    }
+    return hoisted;
+}
+
+// Induction-variable strength reduction.  A header phi i advanced once per
+// iteration by an invariant step is an induction variable, and so is
+// i +/- k for invariant k once rewritten as its own running sum.  Then
+// i * k becomes a running sum stepped by c * k, and a product of two
+// induction variables with constant steps ca, cb becomes p += u,
+// u += 2 * ca * cb.  Arithmetic wraps, so the sums match the products
+// exactly.  Sums derived from an already reduced variable are reduced too,
+// so a + i * d needs no per-iteration arithmetic besides the running sum.
+size_t ssaStrengthReduction(SSAFunction &f){
+    vector<SSALoop> loops = findLoops(f);
+    vector<int> defAt = defBlocks(f);
+    size_t reduced = 0;
+    auto wrap = [](TACOp op, long long x, long long y){
+        unsigned long long a = x, b = y;
+        return (long long)(op==TACOp::MUL ? a * b : op==TACOp::ADD ? a + b : a - b);
+    };
+    for(auto &loop : loops){
+        if(f.blocks[loop.header].preds.size() != 2) continue;
+        size_t li = f.blocks[loop.header].preds[0]==loop.latch ? 0 : 1, pi = 1 - li;
+        if(f.blocks[loop.header].preds[li] != loop.latch || f.blocks[loop.header].preds[pi] != loop.preheader) continue;
+        auto invariant = [&](int v){ return (size_t)v >= defAt.size() || defAt[v] < 0 || !loop.body[defAt[v]]; };
+        auto inNested = [&](int b){
+            for(auto &o : loops) if(o.header != loop.header && loop.body[o.header] && o.body[b]) return true;
+            return false;
+        };
+        // Emits a preheader instruction, folding constant operands.
+        auto preheaderOp = [&](TACOp op, int a, int b){
+            if(f.isConst(a) && f.isConst(b)) return f.constant(wrap(op, f.values[a].c, f.values[b].c));
+            if(op==TACOp::MUL && f.isConst(a)) swap(a, b);
+            if(f.isConst(b) && f.values[b].c==(op==TACOp::MUL ? 1 : 0)) return a;
+            if(op==TACOp::MUL && f.isConst(b) && f.values[b].c==0) return b;
+            int v = f.newValue(SSAValue::INSTR);
+            f.blocks[loop.preheader].code.push_back({op, v, a, b});
+            defAt.resize(f.values.size(), -1);
+            defAt[v] = loop.preheader;
+            return v;
+        };
+
+        // Arithmetic defined in the loop, and the values that must keep
+        // their last iteration's value: those carried around the back edge
+        // or read after the loop.
+        map<int,SSAInstr> defined;
+        set<int> carried;
+        for(int b : f.rpo) if(loop.body[b]) for(auto &in : f.blocks[b].code) if(in.def >= 0) defined[in.def] = in;
+        for(auto &p : f.blocks[loop.header].phis) carried.insert(p.args[li]);
+        for(int b : f.rpo){
+            if(loop.body[b]) continue;
+            for(auto &p : f.blocks[b].phis) for(int a : p.args) carried.insert(a);
+            for(auto &in : f.blocks[b].code){ carried.insert(in.a); carried.insert(in.b); }
+            carried.insert(f.blocks[b].cond);
+        }
+
+        struct IV { int init, step; bool derived, linear; };   // linear: the step is invariant
+        map<int,IV> ivs;                       // phi value -> start and (additive) step
+        for(auto &p : f.blocks[loop.header].phis){
+            int next = p.args[li];
+            auto it = defined.find(next);
+            if(it==defined.end() || inNested(defAt[next])) continue;
+            SSAInstr &in = it->second;
+            int step = -1;
+            if(in.op==TACOp::ADD && in.a==p.def && invariant(in.b)) step = in.b;
+            else if(in.op==TACOp::ADD && in.b==p.def && invariant(in.a)) step = in.a;
+            else if(in.op==TACOp::SUB && in.a==p.def && invariant(in.b)) step = preheaderOp(TACOp::SUB, f.constant(0), in.b);
+            if(step < 0 || (f.isConst(step) && f.values[step].c==0)) continue;
+            ivs[p.def] = {p.args[pi], step, false, true};
+        }
+        if(ivs.empty()) continue;
+
+        vector<SSAPhi> newPhis;
+        vector<SSAInstr> updates;
+        set<int> removed;
+        auto newIV = [&](int init, int step, bool linear){
+            int v = f.newValue(SSAValue::PHI), next = f.newValue(SSAValue::INSTR);
+            defAt.resize(f.values.size(), -1);
+            defAt[v] = loop.header; defAt[next] = loop.latch;
+            updates.push_back({TACOp::ADD, next, v, step});
+            SSAPhi p{v, -1, vector<int>(2)};
+            p.args[pi] = init; p.args[li] = next;
+            newPhis.push_back(p);
+            ivs[v] = {init, step, true, linear};
+            return v;
+        };
+        auto replace = [&](int old, int v){ f.repl[old] = v; removed.insert(old); };
+        // v +/- k with v an induction variable, as (base, offset, sign).
+        auto affine = [&](int v, int &base, int &k, bool &minus){
+            auto it = defined.find(v);
+            if(it==defined.end() || removed.count(v)) return false;
+            SSAInstr &in = it->second;
+            int a = f.resolve(in.a), b = f.resolve(in.b);
+            minus = in.op==TACOp::SUB;
+            if((in.op==TACOp::ADD || minus) && ivs.count(a) && invariant(b)){ base = a; k = b; return true; }
+            if(in.op==TACOp::ADD && ivs.count(b) && invariant(a)){ base = b; k = a; return true; }
+            return false;
+        };
+        // Resolves v to an induction variable, reducing an affine sum first
+        // (a carried sum is kept and only shadowed by the new variable).
+        map<int,int> shadow;
+        auto asIV = [&](int v) -> int {
+            v = f.resolve(v);
+            if(ivs.count(v)) return v;
+            if(shadow.count(v)) return shadow[v];
+            int base, k; bool minus;
+            if(!affine(v, base, k, minus)) return -1;
+            IV iv = ivs[base];
+            int r = newIV(preheaderOp(minus ? TACOp::SUB : TACOp::ADD, iv.init, k), iv.step, iv.linear);
+            shadow[v] = r;
+            if(!carried.count(v)) replace(v, r);
+            return r;
+        };
+        // The induction variable v is or would be based on, or nullptr.
+        auto ivBase = [&](int v) -> const IV* {
+            int base, k; bool minus;
+            v = f.resolve(v);
+            if(ivs.count(v)) return &ivs[v];
+            return affine(v, base, k, minus) ? &ivs[base] : nullptr;
+        };
+
+        map<pair<int,int>,int> products;
+        size_t replaced = 0;
+        for(int b : f.rpo){
+            if(!loop.body[b]) continue;
+            for(auto in : f.blocks[b].code){
+                if(removed.count(in.def)) continue;
+                int a = f.resolve(in.a), c = f.resolve(in.b);
+                if(in.op==TACOp::ADD || in.op==TACOp::SUB){
+                    int base, k; bool minus;
+                    if(!carried.count(in.def) && affine(in.def, base, k, minus) && ivs[base].derived) asIV(in.def);
+                    continue;
+                }
+                if(in.op != TACOp::MUL || carried.count(in.def)) continue;
+                int r = -1;
+                const IV *ba = ivBase(a), *bc = ivBase(c);
+                if(ba && invariant(c)){ swap(a, c); swap(ba, bc); }
+                if(invariant(a) && bc && bc->linear){
+                    int x = asIV(c);
+                    int &memo = products[{x, a}];
+                    if(!memo){
+                        int init = preheaderOp(TACOp::MUL, ivs[x].init, a), step = preheaderOp(TACOp::MUL, ivs[x].step, a);
+                        memo = f.isConst(step) && f.values[step].c==0 ? init : newIV(init, step, true);
+                    }
+                    r = memo;
+                } else if(ba && bc && f.isConst(ba->step) && f.isConst(bc->step)){
+                    int x = asIV(a), y = asIV(c);
+                    if(x > y) swap(x, y);
+                    IV ix = ivs[x], iy = ivs[y];
+                    int &memo = products[{x, -1 - y}];
+                    if(!memo){
+                        // u = x * cy + y * cx + cx * cy is what p gains per trip.
+                        long long cx = f.values[ix.step].c, cy = f.values[iy.step].c;
+                        int u0 = preheaderOp(TACOp::ADD,
+                                    preheaderOp(TACOp::ADD, preheaderOp(TACOp::MUL, ix.init, iy.step),
+                                                            preheaderOp(TACOp::MUL, iy.init, ix.step)),
+                                    f.constant(wrap(TACOp::MUL, cx, cy)));
+                        int u = newIV(u0, f.constant(wrap(TACOp::MUL, 2, wrap(TACOp::MUL, cx, cy))), true);
+                        memo = newIV(preheaderOp(TACOp::MUL, ix.init, iy.init), u, false);
+                        // p += u has to read u before u advances.
+                        swap(updates[updates.size() - 1], updates[updates.size() - 2]);
+                    }
+                    r = memo;
+                } else continue;
+                replace(in.def, r);
+                replaced++;
+            }
+        }
+        // Every new variable costs an addition per trip; keep the rewrite
+        // only if the instructions it removes from blocks that run on every
+        // trip (those dominating the latch) pay for them.  i * i alone, for
+        // instance, would trade one multiplication for two additions.
+        vector<char> everyTrip(f.blocks.size(), 0);
+        for(int b = loop.latch; ; b = f.idom[b]){
+            everyTrip[b] = 1;
+            if(b == loop.header) break;
+        }
+        size_t saved = count_if(removed.begin(), removed.end(), [&](int v){ return everyTrip[defAt[v]]; });
+        if(updates.size() > saved){
+            for(int v : removed) f.repl[v] = -1;
+            continue;
+        }
+        reduced += replaced;
+        if(newPhis.empty()) continue;
+        for(int b : f.rpo){
+            if(!loop.body[b]) continue;
+            auto &code = f.blocks[b].code;
+            code.erase(remove_if(code.begin(), code.end(), [&](SSAInstr &in){ return removed.count(in.def) > 0; }), code.end());
+        }
+        for(auto &p : newPhis) f.blocks[loop.header].phis.push_back(p);
+        // The latch runs exactly once per iteration, after every use.
+        auto &code = f.blocks[loop.latch].code;
+        code.insert(code.end(), updates.begin(), updates.end());
+        f.applyReplacements();
+    }
+    return reduced;
+}
+
+// Dead code elimination: only prints, branch conditions and divisions that
+// may trap are roots; everything not reachable from them through operands
+// and phi arguments is deleted.
+void ssaDCE(SSAFunction &f){
+    size_t nv = f.values.size();
+    vector<char> live(nv, 0);
+    vector<pair<int,int>> defAt(nv, {-1, 0});   // (block, index or -1-phi)
+    for(size_t b = 0; b < f.blocks.size(); b++){
+        auto &blk = f.blocks[b];
+        if(blk.dead) continue;
+        for(size_t k = 0; k < blk.phis.size(); k++) defAt[blk.phis[k].def] = {(int)b, -1 - (int)k};
+        for(size_t k = 0; k < blk.code.size(); k++) if(blk.code[k].def >= 0) defAt[blk.code[k].def] = {(int)b, (int)k};
+    }
+    vector<int> work;
+    auto mark = [&](int v){ if(v >= 0 && !live[v]){ live[v] = 1; work.push_back(v); } };
+    auto mayTrap = [&](const SSAInstr &in){
+        if(in.op!=TACOp::DIV && in.op!=TACOp::MOD) return false;
+        return !f.isConst(in.b) || f.values[in.b].c==0 || f.values[in.b].c==-1;
+    };
+    for(auto &blk : f.blocks){
+        if(blk.dead) continue;
+        mark(blk.cond);
+        for(auto &in : blk.code){
+            if(in.op==TACOp::PRINT){ mark(in.a); }
+            else if(mayTrap(in)) mark(in.def);
+        }
+    }
+    while(!work.empty()){
+        int v = work.back(); work.pop_back();
+        auto d = defAt[v];
+        if(d.first < 0) continue;
+        auto &blk = f.blocks[d.first];
+        if(d.second < 0) for(int a : blk.phis[-1 - d.second].args) mark(a);
+        else { mark(blk.code[d.second].a); mark(blk.code[d.second].b); }
+    }
+    for(auto &blk : f.blocks){
+        if(blk.dead) continue;
+        blk.phis.erase(remove_if(blk.phis.begin(), blk.phis.end(), [&](SSAPhi &p){ return !live[p.def]; }), blk.phis.end());
+        blk.code.erase(remove_if(blk.code.begin(), blk.code.end(), [&](SSAInstr &in){
+            return in.op!=TACOp::PRINT && !live[in.def];
+        }), blk.code.end());
+    }
+}
+
+// Lowers SSA back to TAC.  Instruction results get fresh temporaries,
+// phis live in their variable's slot unless another version of that
+// variable is live into the phi's block, and phi moves are placed on the
+// incoming edges as sequentialized parallel copies.
+void lowerFromSSA(SSAFunction &f, TACProgram &out){
+    const int NONE = -1;
+    size_t nv = f.values.size();
+    vector<TACId> storage(nv, 0);
+    vector<char> hasStorage(nv, 0);
+    for(auto &blk : f.blocks){
+        if(blk.dead) continue;
+        for(auto &in : blk.code) if(in.def >= 0){ storage[in.def] = out.newTemp(); hasStorage[in.def] = 1; }
+        for(auto &p : blk.phis){ storage[p.def] = p.var >= 0 ? TACProgram::var(p.var) : out.newTemp(); hasStorage[p.def] = 1; }
+    }
+
+    // Blocks into which each phi value is live (walking back from its uses).
+    vector<vector<int>> liveInPhis(f.blocks.size());
+    {
+        vector<int> defBlock(nv, NONE), stamp(f.blocks.size(), -1);
+        for(size_t b = 0; b < f.blocks.size(); b++) for(auto &p : f.blocks[b].phis) defBlock[p.def] = b;
+        vector<vector<pair<int,bool>>> usesOf(nv);   // (block, reached as phi argument through that pred)
+        for(size_t b = 0; b < f.blocks.size(); b++){
+            auto &blk = f.blocks[b];
+            if(blk.dead) continue;
+            auto use = [&](int v){ if(v >= 0 && defBlock[v] != NONE) usesOf[v].push_back({(int)b, false}); };
+            for(auto &in : blk.code){ use(in.a); use(in.b); }
+            use(blk.cond);
+            for(auto &p : blk.phis) for(size_t i = 0; i < p.args.size(); i++){
+                int a = p.args[i];
+                if(a >= 0 && defBlock[a] != NONE) usesOf[a].push_back({blk.preds[i], true});
+            }
+        }
+        for(size_t v = 0; v < nv; v++){
+            if(usesOf[v].empty()) continue;
+            vector<int> work;
+            for(auto &u : usesOf[v]){
+                // A use at the end of a predecessor makes v live-out there;
+                // live-in follows unless that block defines v.
+                if(u.first != defBlock[v] && stamp[u.first] != (int)v){ stamp[u.first] = v; work.push_back(u.first); }
+            }
+            while(!work.empty()){
+                int b = work.back(); work.pop_back();
+                liveInPhis[b].push_back(v);
+                for(int p : f.blocks[b].preds)
+                    if(p != defBlock[v] && stamp[p] != (int)v){ stamp[p] = v; work.push_back(p); }
+            }
+        }
+    }
+    for(size_t b = 0; b < f.blocks.size(); b++){
+        auto &blk = f.blocks[b];
+        if(blk.dead || blk.phis.empty()) continue;
+        for(auto &p : blk.phis){
+            for(int q : liveInPhis[b]){
+                if(q != p.def && storage[q]==storage[p.def]){
+                    storage[p.def] = out.newTemp();
+                    break;
+                }
+            }
+        }
+    }
+
+    auto operand = [&](int v) -> TACId {
+        if(f.isConst(v)) return out.constant(f.values[v].c);
+        return hasStorage[v] ? storage[v] : out.constant(0);
+    };
+    // Parallel copies for the edge pred -> succ, in a safe order; cycles
+    // are broken through a scratch temporary.
+    auto edgeCopies = [&](int pred, int succ){
+        vector<pair<TACId,int>> moves;   // (destination, source value)
+        auto &s = f.blocks[succ];
+        size_t j = find(s.preds.begin(), s.preds.end(), pred) - s.preds.begin();
+        for(auto &p : s.phis){
+            int a = p.args[j];
+            if(a==0 || (!f.isConst(a) && storage[a]==storage[p.def])) continue;
+            moves.push_back({storage[p.def], a});
+        }
+        vector<pair<TACId,TACId>> pending;
+        for(auto &m : moves) pending.push_back({m.first, operand(m.second)});
+        vector<pair<TACId,TACId>> seq;
+        while(!pending.empty()){
+            bool progress = false;
+            for(size_t k = 0; k < pending.size(); k++){
+                bool readLater = false;
+                for(size_t o = 0; o < pending.size(); o++)
+                    if(o != k && TACProgram::kind(pending[o].second)!=TACProgram::CONST && pending[o].second==pending[k].first) readLater = true;
+                if(!readLater){
+                    seq.push_back(pending[k]);
+                    pending.erase(pending.begin() + k);
+                    progress = true;
+                    break;
+                }
+            }
+            if(!progress){
+                TACId scratch = out.newTemp(), d = pending[0].first;
+                seq.push_back({scratch, d});
+                for(auto &pm : pending) if(pm.second==d) pm.second = scratch;
+            }
+        }
+        return seq;
+    };
+
+    vector<int> layout;
+    for(size_t b = 2; b < f.blocks.size(); b++) if(!f.blocks[b].dead) layout.push_back(b);
+    stable_sort(layout.begin(), layout.end(), [&](int x, int y){ 
+        if(f.blocks[x].start != f.blocks[y].start) return f.blocks[x].start < f.blocks[y].start;
+        return f.blocks[x].leading > f.blocks[y].leading;
+    });
+    layout.insert(layout.begin(), SSAFunction::ENTRY);
+
+    vector<uint32_t> blockPos(f.blocks.size(), 0);
+    vector<pair<uint32_t,int>> fixups;       // (jump pc, block)
+    vector<pair<uint32_t,int>> outOfLine;                  // (IFZ pc, target block)
+    vector<vector<pair<TACId,TACId>>> outOfLineCopies;
+    for(size_t li = 0; li < layout.size(); li++){
+        int b = layout[li];
+        auto &blk = f.blocks[b];
+        int next = li + 1 < layout.size() ? layout[li + 1] : SSAFunction::EXIT;
+        blockPos[b] = out.count;
+        for(auto &in : blk.code){
+            if(in.op==TACOp::PRINT) out.emit(TACOp::PRINT, 0, operand(in.a));
+            else out.emit(in.op, storage[in.def], operand(in.a), in.b >= 0 ? operand(in.b) : 0);
+        }
+        auto jumpTo = [&](int s){
+            if(s != next) fixups.push_back({out.emit(TACOp::GOTO, 0), s});
+        };
+        if(blk.cond >= 0){
+            auto zeroCopies = edgeCopies(b, blk.succs[1]);
+            uint32_t j = out.emit(TACOp::IFZ, 0, operand(blk.cond));
+            if(zeroCopies.empty()) fixups.push_back({j, blk.succs[1]});
+            else { outOfLine.push_back({j, blk.succs[1]}); outOfLineCopies.push_back(zeroCopies); }
+            for(auto &c : edgeCopies(b, blk.succs[0])) out.emit(TACOp::COPY, c.first, c.second);
+            jumpTo(blk.succs[0]);
+        } else if(!blk.succs.empty()){
+            for(auto &c : edgeCopies(b, blk.succs[0])) out.emit(TACOp::COPY, c.first, c.second);
+            jumpTo(blk.succs[0]);
+        }
+    }
+    // Edge blocks for taken branches that need phi copies go after the
+    // program body, which then has to jump over them to the end.
+    uint32_t endJump = outOfLine.empty() ? 0 : out.emit(TACOp::GOTO, 0);
+    for(size_t k = 0; k < outOfLine.size(); k++){
+        out.dst[outOfLine[k].first] = out.count;
+        for(auto &c : outOfLineCopies[k]) out.emit(TACOp::COPY, c.first, c.second);
+        fixups.push_back({out.emit(TACOp::GOTO, 0), outOfLine[k].second});
+    }
+    blockPos[SSAFunction::EXIT] = out.count;
+    if(!outOfLine.empty()) out.dst[endJump] = out.count;
+    for(auto &fx : fixups) out.dst[fx.first] = blockPos[fx.second];
+}
+
+// "t = a op b; ...; x = t" becomes "x = a op b" when t has no other reader
+// and x is not touched in between, inside one basic block.
+uint32_t coalesceTempCopies(TACProgram &p){
+    vector<uint32_t> uses(p.numTemps + 1, 0), defs(p.numTemps + 1, 0), defAt(p.numTemps + 1, 0);
+    vector<char> target(p.count + 1, 0);
+    auto touches = [&](uint32_t pc, TACId x){
+        if(p.op[pc]==TACOp::GOTO) return false;
+        if(p.a[pc]==x || (isBinaryTAC(p.op[pc]) && p.b[pc]==x)) return true;
+        return !p.isJump(pc) && p.op[pc]!=TACOp::PRINT && p.dst[pc]==x;
+    };
+    for(uint32_t pc = 0; pc < p.count; pc++){
+        if(p.isJump(pc)) target[p.target(pc)] = 1;
+        if(p.op[pc]==TACOp::GOTO) continue;
+        if(TACProgram::kind(p.a[pc])==TACProgram::TEMP) uses[TACProgram::index(p.a[pc])]++;
+        if(isBinaryTAC(p.op[pc]) && TACProgram::kind(p.b[pc])==TACProgram::TEMP) uses[TACProgram::index(p.b[pc])]++;
+        if(!p.isJump(pc) && p.op[pc]!=TACOp::PRINT && TACProgram::kind(p.dst[pc])==TACProgram::TEMP){
+            defs[TACProgram::index(p.dst[pc])]++;
+            defAt[TACProgram::index(p.dst[pc])] = pc;
+        }
+    }
+    vector<char> drop(p.count, 0);
+    uint32_t removed = 0, blockStart = 0;
+    for(uint32_t pc = 0; pc < p.count; pc++){
+        if(target[pc]) blockStart = pc;
+        if(p.isJump(pc)){ blockStart = pc + 1; continue; }
+        if(p.op[pc]!=TACOp::COPY || TACProgram::kind(p.a[pc])!=TACProgram::TEMP) continue;
+        uint32_t t = TACProgram::index(p.a[pc]), d = defAt[t];
+        if(uses[t]!=1 || defs[t]!=1 || d < blockStart || d >= pc || !isBinaryTAC(p.op[d])) continue;
+        bool clear = true;
+        for(uint32_t k = d + 1; k < pc && clear; k++) if(!drop[k] && touches(k, p.dst[pc])) clear = false;
+        if(!clear) continue;
+        p.dst[d] = p.dst[pc];
+        drop[pc] = 1;
+        removed++;
+    }
+    vector<uint32_t> newPos(p.count + 1, 0);
+    uint32_t w = 0;
+    for(uint32_t pc = 0; pc <= p.count; pc++){
+        newPos[pc] = w;
+        if(pc < p.count && !drop[pc]) w++;
+    }
+    w = 0;
+    for(uint32_t pc = 0; pc < p.count; pc++){
+        if(drop[pc]) continue;
+        p.op[w] = p.op[pc]; p.dst[w] = p.isJump(pc) ? newPos[p.target(pc)] : p.dst[pc];
+        p.a[w] = p.a[pc]; p.b[w] = p.b[pc];
+        w++;
+    }
+    p.count = w;
+    return removed;
+}
+
+// Runs the pass pipeline for -O1/-O2 and replaces prog with the result.
+void optimizeTAC(TACProgram &prog, int level, bool debug=false, bool trace=true){
+    if(level <= 0) return;
+    SSAFunction f;
+    f.debug = debug;
+    f.build(prog);
+    size_t before = prog.count;
+    size_t phis = 0;
+    for(auto &b : f.blocks) phis += b.phis.size();
+    if(trace) cout << "[OPTIMIZATION] SSA form: " << f.blocks.size() << " blocks, " << phis << " phis, "
+         << f.instructionCount() << " instructions" << endl;
+    if(debug){ cout << "[OPTIMIZATION] SSA before passes:" << endl; f.dump(cout); }
+
+    auto run = [&](const char *name, void (*pass)(SSAFunction&)){
+        size_t n = f.instructionCount();
+        pass(f);
+        if(trace) cout << "[OPTIMIZATION] " << name << ": removed " << (long long)n - (long long)f.instructionCount() << " instructions" << endl;
+    };
+    run("sparse conditional constant propagation", ssaSCCP);
+    run("copy propagation", ssaCopyPropagation);
+    if(level >= 2){
+        size_t hoisted = ssaLICM(f);
+        if(trace) cout << "[OPTIMIZATION] loop-invariant code motion: hoisted " << hoisted << " instructions" << endl;
+        run("global value numbering", ssaGVN);
+        size_t reduced = ssaStrengthReduction(f);
+        if(trace) cout << "[OPTIMIZATION] strength reduction: replaced " << reduced << " multiplications" << endl;
+    }
+    run("dead code elimination", ssaDCE);
+    if(debug){ cout << "[OPTIMIZATION] SSA after passes:" << endl; f.dump(cout); }
+
+    TACProgram out(prog.slots);
+    out.reserve(f.instructionCount() * 2 + 16, 16);
+    lowerFromSSA(f, out);
+    uint32_t merged = coalesceTempCopies(out);
+    if(trace){
+        cout << "[OPTIMIZATION] out of SSA: coalesced " << merged << " copies" << endl;
+        cout << "[OPTIMIZATION] TAC at -O" << level << ": " << before << " -> " << out.count << " instructions" << endl;
+    }
+    prog = move(out);
+}
+
+// ============================================================================
+// PHASE 6: BYTECODE COMPILER - Register Machine Code Generation
+// ============================================================================
+// Register-machine bytecode: every instruction is a fixed 4-word record
+// {op, dst, a, b}.  Registers are laid out as [variables | constants | temps]
+// so an operand is always a plain register index, whatever it refers to.
+enum class Op : int32_t {
+    ADD, SUB, MUL, DIV, MOD,
+    EQ, NEQ, LT, GT, LTE, GTE,
+    MOV,        // r[dst] = r[a]
+    PRINT,      // print r[a]
+    JMP,        // pc = dst
+    JZ,         // if(!r[a]) pc = dst
+    JNLT, JNGT, JNLTE, JNGTE, JNEQ, JNNEQ,  // fused compare-and-branch: if(!(r[a] OP r[b])) pc = dst
+    HALT,
+};
+
+struct Instr { Op op; int32_t dst, a, b; };
+
+static_assert(static_cast<int>(Op::GTE) == static_cast<int>(BinOp::GTE), "Op must mirror BinOp");
+
+string opName(Op op){
+    static const char *names[] = {
+        "add", "sub", "mul", "div", "mod",
+        "eq", "neq", "lt", "gt", "lte", "gte",
+        "mov", "print", "jmp", "jz",
+        "jnlt", "jngt", "jnlte", "jngte", "jneq", "jnneq",
+        "halt",
+    };
+    return names[static_cast<int>(op)];
+}
+
+struct Bytecode {
+    vector<Instr> code;
+    vector<long long> constants;   // initial values of the constant registers
+    vector<string> varNames;       // register i < varNames.size() holds variable varNames[i]
+    int numRegs = 0;
+
+    void dump(ostream &out) const {
+        for(size_t pc = 0; pc < code.size(); pc++){
+            const Instr &in = code[pc];
+            out << setw(4) << pc << "  " << left << setw(6) << opName(in.op) << right
+                << " dst=" << in.dst << " a=" << in.a << " b=" << in.b << "\n";
+        }
+    }
+};
+
+struct BytecodeCompiler {
+    Bytecode bc;
+    map<long long,int> constSlot;
+    vector<pair<int,long long>> pendingConsts;   // (constant index, value)
+    int numTemps = 0, maxTemps = 0;
+    const Ast &ast;
+    bool debug;
+    // Expressions and statements in progress, innermost last (see genExprInto
+    // and genBlock); jump is a branch still waiting for its target.
+    struct ExprFrame { NodeId e; int dst, saved, A, B; uint8_t k; };
+    vector<ExprFrame> exprs;
+    struct Pending { NodeId id; uint32_t k; int jump, top; };
+    vector<Pending> open;
+
+    // Variables keep the slot numbers the parser interned them with.
+    BytecodeCompiler(const Ast &t, bool dbg=false): ast(t), debug(dbg) { bc.varNames = t.names.names; }
+
+    // Temporaries and constants are numbered locally and relocated in finish(),
+    // once the number of variables and constants is known.
+    static const int CONST_TAG = 1 << 29;
+    static const int TEMP_TAG  = 1 << 30;
+
+    int constant(long long v){
+        auto it = constSlot.find(v);
+        if(it != constSlot.end()) return it->second;
+        int r = CONST_TAG | (int)bc.constants.size();
+        bc.constants.push_back(v);
+        constSlot[v] = r;
+        return r;
+    }
+
+    int newTemp(){
+        int r = TEMP_TAG | numTemps++;
+        maxTemps = max(maxTemps, numTemps);
+        return r;
+    }
+
+    int emit(Op op, int dst, int a=0, int b=0){
+        bc.code.push_back({op, dst, a, b});
+        return bc.code.size() - 1;
+    }
+
+    // Op::ADD..Op::GTE mirror BinOp one-to-one.
+    static Op binaryOp(BinOp op){ return static_cast<Op>(op); }
+
+    static bool isLeaf(const Node &n){ return n.kind==NodeKind::INT || n.kind==NodeKind::VAR; }
+
+    int leafOperand(NodeId e){
+        const Node &n = ast[e];
+        return n.kind==NodeKind::INT ? constant(n.value()) : (int)n.a;
+    }
+
+    // Operand for e: variables and literals are used in place, anything else
+    // is evaluated into a fresh temporary.
+    int operand(NodeId e){
+        if(isLeaf(ast[e])) return leafOperand(e);
+        int t = newTemp();
+        genExprInto(e, t);
+        return t;
+    }
+
+    // Each operator's non-leaf operands get a temporary and are generated
+    // first.  The frames stand in for recursion: k counts the operands
+    // placed, and `saved` restores the temporaries once the operator is out.
+    void genExprInto(NodeId root, int dst){
+        size_t base = exprs.size();
+        exprs.push_back({root, dst, 0, 0, 0, 0});
+        while(exprs.size() > base){
+            ExprFrame &f = exprs.back();
+            const Node &n = ast[f.e];
+            if(!n.isBinary()){
+                emit(Op::MOV, f.dst, leafOperand(f.e));
+                exprs.pop_back();
+                continue;
+            }
+            if(f.k < 2){
+                if(f.k == 0) f.saved = numTemps;
+                NodeId child = f.k == 0 ? n.a : n.b;
+                int &slot = f.k++ == 0 ? f.A : f.B;
+                if(isLeaf(ast[child])){
+                    slot = leafOperand(child);
+                } else {
+                    int t = newTemp();
+                    slot = t;           // before the push moves f
+                    exprs.push_back({child, t, 0, 0, 0, 0});
+                }
+                continue;
+            }
+            emit(binaryOp(n.op()), f.dst, f.A, f.B);
+            numTemps = f.saved;
+            exprs.pop_back();
+        }
+    }
+
+    // Emits a branch to be patched with the false target of cond; returns its index.
+    int genBranchIfFalse(NodeId cond){
+        int saved = numTemps;
+        int at;
+        const Node &b = ast[cond];
+        Op fused = Op::HALT;
+        if(b.isBinary()){
+            switch(b.op()){
+                case BinOp::LT:  fused = Op::JNLT; break;
+                case BinOp::GT:  fused = Op::JNGT; break;
+                case BinOp::LTE: fused = Op::JNLTE; break;
+                case BinOp::GTE: fused = Op::JNGTE; break;
+                case BinOp::EQ:  fused = Op::JNEQ; break;
+                case BinOp::NEQ: fused = Op::JNNEQ; break;
+                default: break;
+            }
+        }
+        if(fused != Op::HALT){
+            int A = operand(b.a);
+            int B = operand(b.b);
+            at = emit(fused, -1, A, B);
+        } else {
+            at = emit(Op::JZ, -1, operand(cond));
+        }
+        numTemps = saved;
+        return at;
+    }
+
+    // Straight-line statements are compiled at once; an if or while emits
+    // its branch, and genBlock finishes it once its blocks are done.
+    void genStmt(NodeId s){
+        const Node &n = ast[s];
+        if(n.kind==NodeKind::ASSIGN){
+            genExprInto(n.b, n.a);
+        } else if(n.kind==NodeKind::PRINT){
+            int saved = numTemps;
+            emit(Op::PRINT, 0, operand(n.a));
+            numTemps = saved;
+        } else if(n.kind==NodeKind::IF){
+            int jFalse = genBranchIfFalse(n.a);
+            open.push_back({s, 0, jFalse, 0});
+            open.push_back({n.b, 0, 0, 0});
+        } else if(n.kind==NodeKind::WHILE){
+            int top = bc.code.size();
+            int jExit = genBranchIfFalse(n.a);
+            open.push_back({s, 0, jExit, top});
+            open.push_back({n.b, 0, 0, 0});
+        } else if(n.kind==NodeKind::BLOCK){
+            open.push_back({s, 0, 0, 0});
+        } else {
+            errs()<<"[BYTECODE ERROR] Unknown statement type\n";
+            fail();
+        }
+    }
+
+    void genBlock(NodeId root){
+        open.push_back({root, 0, 0, 0});
+        while(!open.empty()){
+            Pending &p = open.back();
+            const Node &n = ast[p.id];
+            if(n.kind==NodeKind::BLOCK){
+                if(p.k == n.b) open.pop_back();
+                else genStmt(ast.stmts(p.id)[p.k++]);
+            } else if(n.kind==NodeKind::IF){
+                if(p.k++ == 0 && n.c != NO_NODE){
+                    // then block done: jump over the else block
+                    int jEnd = emit(Op::JMP, -1);
+                    bc.code[p.jump].dst = bc.code.size();
+                    p.jump = jEnd;
+                    open.push_back({n.c, 0, 0, 0});
+                    continue;
+                }
+                bc.code[p.jump].dst = bc.code.size();
+                open.pop_back();
+            } else {
+                // while body done: back to the condition
+                emit(Op::JMP, p.top);
+                bc.code[p.jump].dst = bc.code.size();
+                open.pop_back();
+            }
+        }
+    }
+
+    // Rewrites tagged constant/temporary operands into final register numbers.
+    void finish(){
+        emit(Op::HALT, 0);
+        int nv = bc.varNames.size(), nc = bc.constants.size();
+        auto reloc = [&](int32_t &r){
+            if(r >= 0 && (r & TEMP_TAG)) r = nv + nc + (r & ~TEMP_TAG);
+            else if(r >= 0 && (r & CONST_TAG)) r = nv + (r & ~CONST_TAG);
+        };
+        for(auto &in : bc.code){
+            bool jump = in.op==Op::JMP || in.op==Op::JZ || (in.op>=Op::JNLT && in.op<=Op::JNNEQ);
+            if(!jump && in.op!=Op::PRINT && in.op!=Op::HALT) reloc(in.dst);
+            reloc(in.a);
+            reloc(in.b);
+        }
+        bc.numRegs = nv + nc + maxTemps;
+        if(debug) cout << "[BYTECODE] " << bc.code.size() << " instructions, " << nv << " variables, "
+                       << nc << " constants, " << maxTemps << " temporaries" << endl;
+    }
+
+    Bytecode compile(){
+        genBlock(ast.root);
+        finish();
+        return move(bc);
+    }
+};
+
+// ============================================================================
+// PHASE 6: VIRTUAL MACHINE - Threaded Bytecode Interpreter
+// ============================================================================
+// Uses computed goto (GCC/Clang "labels as values") so each handler jumps
+// straight to the next one; falls back to a switch loop elsewhere.
+// Runs code whose registers are [variables | constants | temporaries]; the
+// arrays may live in a Bytecode or in a mapped .mlc file.
+void runBytecode(const Instr *code, const long long *constants, size_t numConsts, size_t nv, int numRegs){
+    // Semantic analysis rejects any read that is not dominated by an
+    // assignment, so registers need no "initialized" check at run time.
+    vector<long long> regs(numRegs, 0);
+    for(size_t i = 0; i < numConsts; i++) regs[nv + i] = constants[i];
+
+    long long *r = regs.data();
+    PrintSink &out = programOut;
+    const Instr *ip = code;
+
+#if defined(__GNUC__)
+    static void *dispatch[] = {
+        &&L_ADD, &&L_SUB, &&L_MUL, &&L_DIV, &&L_MOD,
+        &&L_EQ, &&L_NEQ, &&L_LT, &&L_GT, &&L_LTE, &&L_GTE,
+        &&L_MOV, &&L_PRINT, &&L_JMP, &&L_JZ,
+        &&L_JNLT, &&L_JNGT, &&L_JNLTE, &&L_JNGTE, &&L_JNEQ, &&L_JNNEQ,
+        &&L_HALT,
+    };
+    #define VM_CASE(name) L_##name:
+    #define VM_NEXT() goto *dispatch[static_cast<int>(ip->op)]
+    VM_NEXT();
+#else
+    #define VM_CASE(name) case Op::name:
+    #define VM_NEXT() break
+    for(;;) switch(ip->op){
+#endif
+    VM_CASE(ADD)   r[ip->dst] = r[ip->a] + r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(SUB)   r[ip->dst] = r[ip->a] - r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(MUL)   r[ip->dst] = r[ip->a] * r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(DIV)   checkDivisor(r[ip->a], r[ip->b]); r[ip->dst] = r[ip->a] / r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(MOD)   checkDivisor(r[ip->a], r[ip->b]); r[ip->dst] = r[ip->a] % r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(EQ)    r[ip->dst] = r[ip->a] == r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(NEQ)   r[ip->dst] = r[ip->a] != r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(LT)    r[ip->dst] = r[ip->a] < r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(GT)    r[ip->dst] = r[ip->a] > r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(LTE)   r[ip->dst] = r[ip->a] <= r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(GTE)   r[ip->dst] = r[ip->a] >= r[ip->b]; ip++; VM_NEXT();
+    VM_CASE(MOV)   r[ip->dst] = r[ip->a]; ip++; VM_NEXT();
+    VM_CASE(PRINT) out.put(r[ip->a]); ip++; VM_NEXT();
+    VM_CASE(JMP)   ip = code + ip->dst; VM_NEXT();
+    VM_CASE(JZ)    ip = r[ip->a] ? ip + 1 : code + ip->dst; VM_NEXT();
+    VM_CASE(JNLT)  ip = r[ip->a] <  r[ip->b] ? ip + 1 : code + ip->dst; VM_NEXT();
+    VM_CASE(JNGT)  ip = r[ip->a] >  r[ip->b] ? ip + 1 : code + ip->dst; VM_NEXT();
+    VM_CASE(JNLTE) ip = r[ip->a] <= r[ip->b] ? ip + 1 : code + ip->dst; VM_NEXT();
+    VM_CASE(JNGTE) ip = r[ip->a] >= r[ip->b] ? ip + 1 : code + ip->dst; VM_NEXT();
+    VM_CASE(JNEQ)  ip = r[ip->a] == r[ip->b] ? ip + 1 : code + ip->dst; VM_NEXT();
+    VM_CASE(JNNEQ) ip = r[ip->a] != r[ip->b] ? ip + 1 : code + ip->dst; VM_NEXT();
+    VM_CASE(HALT)  return;
+#if !defined(__GNUC__)
+    }
+#endif
+    #undef VM_CASE
+    #undef VM_NEXT
+}
+
+void runBytecode(const Bytecode &bc){
+    runBytecode(bc.code.data(), bc.constants.data(), bc.constants.size(), bc.varNames.size(), bc.numRegs);
+}
+
+// ============================================================================
+// PHASE 6: TIERED EXECUTION - x86-64 JIT for Hot Loops
+// ============================================================================
+// A compiled loop region is entered at its header with a pointer to the
+// TAC memory image [variables | temporaries] and returns the TAC index at
+// which the interpreter must resume: either the loop exit, or the
+// instruction that hit a rare path (division or modulo by zero, or
+// LLONG_MIN / -1) so the interpreter can reproduce the exact diagnostic.
+typedef long long (*JitFn)(long long *mem);
+
+#if MINILANG_HAVE_JIT
+static void jitPrint(long long v){ programOut.put(v); }
+
+struct X64Emitter {
+    enum Reg { RAX=0, RCX=1, RDX=2, RBX=3, RSP=4, RBP=5, RSI=6, RDI=7,
+               R8=8, R9, R10, R11, R12, R13, R14, R15 };
+    // Condition codes as encoded in Jcc/SETcc.
+    enum Cond : uint8_t { CC_E=0x4, CC_NE=0x5, CC_L=0xC, CC_GE=0xD, CC_LE=0xE, CC_G=0xF };
+    vector<uint8_t> buf;
+
+    void byte(uint8_t x){ buf.push_back(x); }
+    void imm32(int32_t v){ uint8_t t[4]; memcpy(t, &v, 4); buf.insert(buf.end(), t, t+4); }
+    void imm64(int64_t v){ uint8_t t[8]; memcpy(t, &v, 8); buf.insert(buf.end(), t, t+8); }
+    void rexW(int reg, int rm){ byte(0x48 | ((reg>>3)<<2) | (rm>>3)); }
+    void modrmReg(int reg, int rm){ byte(0xC0 | ((reg&7)<<3) | (rm&7)); }
+    // [base + disp32]; only ever used with base = R15, which needs no SIB byte.
+    void modrmMem(int reg, int base, int32_t disp){ byte(0x80 | ((reg&7)<<3) | (base&7)); imm32(disp); }
+
+    void movRR(int dst, int src){ rexW(src, dst); byte(0x89); modrmReg(src, dst); }
+    void movRM(int dst, int base, int32_t disp){ rexW(dst, base); byte(0x8B); modrmMem(dst, base, disp); }
+    void movMR(int base, int32_t disp, int src){ rexW(src, base); byte(0x89); modrmMem(src, base, disp); }
+    void movRI(int dst, int64_t v){
+        if(v >= INT32_MIN && v <= INT32_MAX){ rexW(0, dst); byte(0xC7); modrmReg(0, dst); imm32((int32_t)v); }
+        else { rexW(0, dst); byte(0xB8 + (dst&7)); imm64(v); }
+    }
+    void add(int dst, int src){ rexW(src, dst); byte(0x01); modrmReg(src, dst); }
+    void sub(int dst, int src){ rexW(src, dst); byte(0x29); modrmReg(src, dst); }
+    void cmp(int dst, int src){ rexW(src, dst); byte(0x39); modrmReg(src, dst); }
+    void test(int dst, int src){ rexW(src, dst); byte(0x85); modrmReg(src, dst); }
+    void imul(int dst, int src){ rexW(dst, src); byte(0x0F); byte(0xAF); modrmReg(dst, src); }
+    void cqo(){ byte(0x48); byte(0x99); }
+    void idiv(int src){ rexW(0, src); byte(0xF7); modrmReg(7, src); }
+    void setccAl(Cond cc){ byte(0x0F); byte(0x90 | cc); byte(0xC0); }
+    void movzxEaxAl(){ byte(0x0F); byte(0xB6); byte(0xC0); }
+    void push(int r){ if(r >= 8) byte(0x41); byte(0x50 + (r&7)); }
+    void pop(int r){ if(r >= 8) byte(0x41); byte(0x58 + (r&7)); }
+    void subRsp8(){ byte(0x48); byte(0x83); byte(0xEC); byte(0x08); }
+    void addRsp8(){ byte(0x48); byte(0x83); byte(0xC4); byte(0x08); }
+    void callAbs(const void *fn){ rexW(0, RAX); byte(0xB8); imm64((int64_t)(intptr_t)fn); byte(0xFF); byte(0xD0); }
+    void ret(){ byte(0xC3); }
+    // Branches return the offset of their rel32 field for later patching.
+    size_t jcc(Cond cc){ byte(0x0F); byte(0x80 | cc); imm32(0); return buf.size() - 4; }
+    size_t jmp(){ byte(0xE9); imm32(0); return buf.size() - 4; }
+    void patch(size_t at, size_t target){ int32_t rel = (int32_t)(target - (at + 4)); memcpy(&buf[at], &rel, 4); }
+};
+
+struct LoopJit {
+    const TACProgram &tac;
+    bool debug;
+    vector<pair<void*,size_t>> mappings;
+
+    // Variables that get a dedicated callee-saved register; R15 holds mem.
+    static constexpr int REG_POOL[] = { X64Emitter::RBX, X64Emitter::RBP, X64Emitter::R12,
+                                        X64Emitter::R13, X64Emitter::R14 };
+
+    vector<uint32_t> tempUses;   // reads of each temporary across the whole program
+
+    LoopJit(const TACProgram &t, bool dbg): tac(t), debug(dbg), tempUses(t.numTemps + 1, 0) {
+        auto count = [&](TACId id){ if(TACProgram::kind(id)==TACProgram::TEMP) tempUses[TACProgram::index(id)]++; };
+        for(uint32_t pc = 0; pc < t.count; pc++){
+            if(t.op[pc]==TACOp::GOTO) continue;
+            count(t.a[pc]);
+            if(isBinaryTAC(t.op[pc])) count(t.b[pc]);
+        }
+    }
+    ~LoopJit(){ for(auto &m : mappings) munmap(m.first, m.second); }
+
+    static X64Emitter::Cond condFor(TACOp op){
+        switch(op){
+            case TACOp::EQ:  return X64Emitter::CC_E;
+            case TACOp::NEQ: return X64Emitter::CC_NE;
+            case TACOp::LT:  return X64Emitter::CC_L;
+            case TACOp::GT:  return X64Emitter::CC_G;
+            case TACOp::LTE: return X64Emitter::CC_LE;
+            default:         return X64Emitter::CC_GE;
+        }
+    }
+    static X64Emitter::Cond invert(X64Emitter::Cond cc){ return (X64Emitter::Cond)(cc ^ 1); }
+    static bool isCompare(TACOp op){ return op >= TACOp::EQ && op <= TACOp::GTE; }
+
+    // Compiles TAC [head, tail] (a loop header through its back-edge goto)
+    // into native code; returns nullptr if the code cannot be mapped.
+    JitFn compile(uint32_t head, uint32_t tail){
+        X64Emitter x;
+        map<uint32_t,int> regOf;   // variable slot -> register
+        {
+            map<uint32_t,int> uses;
+            auto count = [&](TACId id){ if(TACProgram::kind(id)==TACProgram::VAR) uses[TACProgram::index(id)]++; };
+            for(uint32_t pc = head; pc <= tail; pc++){
+                if(tac.isJump(pc)){ if(tac.op[pc]==TACOp::IFZ) count(tac.a[pc]); continue; }
+                count(tac.dst[pc]); count(tac.a[pc]); count(tac.b[pc]);
+            }
+            vector<pair<int,uint32_t>> order;
+            for(auto &u : uses) order.push_back({-u.second, u.first});
+            sort(order.begin(), order.end());
+            for(size_t k = 0; k < order.size() && k < size(REG_POOL); k++) regOf[order[k].second] = REG_POOL[k];
+        }
+        auto disp = [&](TACId id){ return (int32_t)(8 * tac.memIndex(id)); };
+        auto load = [&](int reg, TACId id){
+            if(TACProgram::kind(id)==TACProgram::CONST) { x.movRI(reg, tac.constValue(id)); return; }
+            if(TACProgram::kind(id)==TACProgram::VAR){
+                auto it = regOf.find(TACProgram::index(id));
+                if(it != regOf.end()){ x.movRR(reg, it->second); return; }
+            }
+            x.movRM(reg, X64Emitter::R15, disp(id));
+        };
+        auto store = [&](TACId id, int reg){
+            if(TACProgram::kind(id)==TACProgram::VAR){
+                auto it = regOf.find(TACProgram::index(id));
+                if(it != regOf.end()){ x.movRR(it->second, reg); return; }
+            }
+            x.movMR(X64Emitter::R15, disp(id), reg);
+        };
+
+        // Prologue: save callee-saved registers (keeps rsp 16-byte aligned
+        // for calls), point R15 at mem and load the register variables.
+        const int saved[] = { X64Emitter::RBX, X64Emitter::RBP, X64Emitter::R12,
+                              X64Emitter::R13, X64Emitter::R14, X64Emitter::R15 };
+        for(int r : saved) x.push(r);
+        x.subRsp8();
+        x.movRR(X64Emitter::R15, X64Emitter::RDI);
+        for(auto &rv : regOf) x.movRM(rv.second, X64Emitter::R15, (int32_t)(8 * rv.first));
+
+        vector<size_t> native(tail - head + 1, 0);
+        vector<pair<size_t,uint32_t>> internal;   // (rel32 offset, TAC target inside region)
+        vector<pair<size_t,uint32_t>> exits;      // (rel32 offset, TAC pc to resume at)
+
+        auto branchTo = [&](size_t at, uint32_t tgt){
+            if(tgt >= head && tgt <= tail) internal.push_back({at, tgt});
+            else exits.push_back({at, tgt});
+        };
+
+        for(uint32_t pc = head; pc <= tail; pc++){
+            native[pc - head] = x.buf.size();
+            TACOp op = tac.op[pc];
+            switch(op){
+                case TACOp::COPY:
+                    load(X64Emitter::RAX, tac.a[pc]);
+                    store(tac.dst[pc], X64Emitter::RAX);
+                    break;
+                case TACOp::PRINT:
+                    load(X64Emitter::RDI, tac.a[pc]);
+                    x.callAbs((const void*)&jitPrint);
+                    break;
+                case TACOp::GOTO:
+                    branchTo(x.jmp(), tac.target(pc));
+                    break;
+                case TACOp::IFZ:
+                    load(X64Emitter::RAX, tac.a[pc]);
+                    x.test(X64Emitter::RAX, X64Emitter::RAX);
+                    branchTo(x.jcc(X64Emitter::CC_E), tac.target(pc));
+                    break;
+                default: {
+                    load(X64Emitter::RAX, tac.a[pc]);
+                    load(X64Emitter::RCX, tac.b[pc]);
+                    // "t = a < b; ifz t goto L" fuses into cmp + jcc; the
+                    // temporary need not be stored when the ifz is its only reader.
+                    if(isCompare(op) && pc < tail && tac.op[pc+1]==TACOp::IFZ && tac.a[pc+1]==tac.dst[pc] &&
+                       TACProgram::kind(tac.dst[pc])==TACProgram::TEMP && tempUses[TACProgram::index(tac.dst[pc])]==1){
+                        x.cmp(X64Emitter::RAX, X64Emitter::RCX);
+                        pc++;
+                        native[pc - head] = x.buf.size();
+                        branchTo(x.jcc(invert(condFor(op))), tac.target(pc));
+                        break;
+                    }
+                    switch(op){
+                        case TACOp::ADD: x.add(X64Emitter::RAX, X64Emitter::RCX); break;
+                        case TACOp::SUB: x.sub(X64Emitter::RAX, X64Emitter::RCX); break;
+                        case TACOp::MUL: x.imul(X64Emitter::RAX, X64Emitter::RCX); break;
+                        case TACOp::DIV:
+                        case TACOp::MOD:
+                            x.test(X64Emitter::RCX, X64Emitter::RCX);
+                            exits.push_back({x.jcc(X64Emitter::CC_E), pc});
+                            {
+                                // LLONG_MIN / -1 also traps; RDX is scratch until cqo.
+                                x.movRI(X64Emitter::RDX, -1);
+                                x.cmp(X64Emitter::RCX, X64Emitter::RDX);
+                                size_t ok = x.jcc(X64Emitter::CC_NE);
+                                x.movRI(X64Emitter::RDX, LLONG_MIN);
+                                x.cmp(X64Emitter::RAX, X64Emitter::RDX);
+                                exits.push_back({x.jcc(X64Emitter::CC_E), pc});
+                                x.patch(ok, x.buf.size());
+                            }
+                            x.cqo();
+                            x.idiv(X64Emitter::RCX);
+                            if(op==TACOp::MOD) x.movRR(X64Emitter::RAX, X64Emitter::RDX);
+                            break;
+                        default:
+                            x.cmp(X64Emitter::RAX, X64Emitter::RCX);
+                            x.setccAl(condFor(op));
+                            x.movzxEaxAl();
+                            break;
+                    }
+                    store(tac.dst[pc], X64Emitter::RAX);
+                    break;
+                }
+            }
+        }
+        for(auto &f : internal) x.patch(f.first, native[f.second - head]);
+
+        // Exit stubs load the resume pc and share one epilogue that writes
+        // the register variables back to mem.
+        size_t epilogue = x.buf.size() + exits.size() * 12;
+        for(auto &e : exits){
+            x.patch(e.first, x.buf.size());
+            size_t before = x.buf.size();
+            x.rexW(0, X64Emitter::RAX); x.byte(0xC7); x.modrmReg(0, X64Emitter::RAX); x.imm32(e.second);
+            x.patch(x.jmp(), epilogue);
+            assert(x.buf.size() - before == 12);
+        }
+        for(auto &rv : regOf) x.movMR(X64Emitter::R15, (int32_t)(8 * rv.first), rv.second);
+        x.addRsp8();
+        for(int k = 5; k >= 0; k--) x.pop(saved[k]);
+        x.ret();
+
+        size_t len = x.buf.size();
+        void *mem = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(mem == MAP_FAILED) return nullptr;
+        memcpy(mem, x.buf.data(), len);
+        if(mprotect(mem, len, PROT_READ | PROT_EXEC) != 0){ munmap(mem, len); return nullptr; }
+        mappings.push_back({mem, len});
+        if(debug) cout << "[JIT] Compiled loop TAC " << head << ".." << tail << " into " << len
+                       << " bytes, " << regOf.size() << " register variables" << endl;
+        return (JitFn)mem;
+    }
+};
+#endif
+
+// Tier 0 interprets the TAC and counts back-edges per loop; once a loop
+// passes JIT_THRESHOLD iterations its region is compiled and every later
+// entry through the back-edge runs natively.
+struct TieredExecutor {
+    static const uint32_t JIT_THRESHOLD = 1000;
+    const TACProgram &tac;
+    vector<long long> mem;
+    vector<uint32_t> backEdges;
+    vector<JitFn> compiled;        // indexed by loop header TAC index
+    vector<bool> rejected;
+    bool debug;
+    bool jitEnabled = true;
+    uint64_t executed[16] = {};    // TAC instructions run by tier 0, per opcode
+
+    TieredExecutor(const TACProgram &t, bool dbg=false):
+        tac(t), mem(t.memSize(), 0), backEdges(t.count, 0),
+        compiled(t.count + 1, nullptr), rejected(t.count + 1, false), debug(dbg) {
+        // Constants get their own cells so every operand is a plain load.
+        mem.resize(t.memSize() + t.numConsts);
+        for(uint32_t k = 0; k < t.numConsts; k++) mem[t.memSize() + k] = t.consts[k];
+    }
+
+    size_t cell(TACId id) const {
+        return TACProgram::kind(id)==TACProgram::CONST ? tac.memSize() + TACProgram::index(id) : tac.memIndex(id);
+    }
+
+    void run(){
+#if MINILANG_HAVE_JIT
+        LoopJit jit(tac, debug);
+#endif
+        long long *m = mem.data();
+        uint32_t pc = 0, n = tac.count;
+        PrintSink &out = programOut;
+        while(pc < n){
+            TACOp op = tac.op[pc];
+            executed[(int)op]++;
+            switch(op){
+                case TACOp::COPY:  m[cell(tac.dst[pc])] = m[cell(tac.a[pc])]; pc++; break;
+                case TACOp::PRINT: out.put(m[cell(tac.a[pc])]); pc++; break;
+                case TACOp::IFZ:   pc = m[cell(tac.a[pc])] ? pc + 1 : tac.target(pc); break;
+                case TACOp::GOTO: {
+                    uint32_t head = tac.target(pc);
+                    if(head < pc){
+#if MINILANG_HAVE_JIT
+                        if(jitEnabled && !compiled[head] && !rejected[head] && ++backEdges[pc] >= JIT_THRESHOLD){
+                            compiled[head] = jit.compile(head, pc);
+                            rejected[head] = !compiled[head];
+                        }
+                        if(compiled[head]){ pc = (uint32_t)compiled[head](m); break; }
+#endif
+                    }
+                    pc = head;
+                    break;
+                }
+                default:
+                    m[cell(tac.dst[pc])] = runBinOp(tacBinOp(op), m[cell(tac.a[pc])], m[cell(tac.b[pc])]);
+                    pc++;
+                    break;
             }
-            return result;
         }
     }
 };
 
 // ============================================================================
-// PHASE 2: SYNTAX ANALYSIS - Abstract Syntax Tree Definitions
+// PHASE 6: NATIVE BACKEND - C Emission from TAC
 // ============================================================================
-struct NodeBase { virtual ~NodeBase(){} };
+// Lowers the TAC one instruction per C statement: variables and temporaries
+// become locals, jump targets become labels and ifz/goto become goto.  The
+// result is built with -fwrapv so overflow wraps exactly like the
+// interpreters.
+string cName(const TACProgram &tac, TACId id){
+    switch(TACProgram::kind(id)){
+        case TACProgram::VAR:  return "v_" + tac.slots->names[TACProgram::index(id)];
+        case TACProgram::TEMP: return "t" + to_string(TACProgram::index(id));
+        default: {
+            long long v = tac.constValue(id);
+            if(v == LLONG_MIN) return "(-9223372036854775807LL - 1)";
+            return to_string(v) + "LL";
+        }
+    }
+}
 
-struct Expr : NodeBase { 
-    virtual long long eval(map<string,long long>&env) = 0; 
-    virtual string toString() const = 0;
-};
+void emitC(const TACProgram &tac, ostream &out){
+    out << "/* Generated by minilang from three-address code. */\n";
+    out << "#include <stdio.h>\n#include <stdlib.h>\n\n";
+    // Both faults are undefined in C; they are reported like checkDivisor does.
+    out << "static void ml_div_fault(const char *what){\n"
+           "    fflush(stdout);\n"
+           "    fprintf(stderr, \"[RUNTIME ERROR] Division %s\\n\", what);\n"
+           "    exit(1);\n"
+           "}\n\n";
+    out << "int main(void){\n";
+    for(auto &name : tac.slots->names) out << "    long long v_" << name << " = 0;\n";
+    for(uint32_t t = 1; t <= tac.numTemps; t++) out << "    long long t" << t << ";\n";
+    vector<bool> isTarget(tac.count + 1, false);
+    for(uint32_t pc = 0; pc < tac.count; pc++) if(tac.isJump(pc)) isTarget[tac.target(pc)] = true;
+    for(uint32_t pc = 0; pc <= tac.count; pc++){
+        if(isTarget[pc]) out << "L" << pc << ": ;\n";
+        if(pc == tac.count) break;
+        switch(tac.op[pc]){
+            case TACOp::COPY:
+                out << "    " << cName(tac, tac.dst[pc]) << " = " << cName(tac, tac.a[pc]) << ";\n";
+                break;
+            case TACOp::PRINT:
+                out << "    printf(\"%lld\\n\", " << cName(tac, tac.a[pc]) << ");\n";
+                break;
+            case TACOp::IFZ:
+                out << "    if(!" << cName(tac, tac.a[pc]) << ") goto L" << tac.target(pc) << ";\n";
+                break;
+            case TACOp::GOTO:
+                out << "    goto L" << tac.target(pc) << ";\n";
+                break;
+            default:
+                if(tac.op[pc]==TACOp::DIV || tac.op[pc]==TACOp::MOD){
+                    string a = cName(tac, tac.a[pc]), b = cName(tac, tac.b[pc]);
+                    out << "    if(" << b << " == 0) ml_div_fault(\"by zero\");\n";
+                    out << "    if(" << b << " == -1 && " << a << " == (-9223372036854775807LL - 1)) ml_div_fault(\"overflow\");\n";
+                }
+                out << "    " << cName(tac, tac.dst[pc]) << " = " << cName(tac, tac.a[pc]) << " "
+                    << binOpText(tacBinOp(tac.op[pc])) << " " << cName(tac, tac.b[pc]) << ";\n";
+                break;
+        }
+    }
+    out << "    return 0;\n}\n";
+}
 
-struct Stmt : NodeBase { 
-    virtual void exec(map<string,long long>&env) = 0; 
-    virtual string toString() const = 0;
-};
+// Writes the C translation to <exe>.c and compiles it with $CC (default cc);
+// its warnings are suppressed when not tracing (-q).
+bool buildNative(const TACProgram &tac, const string &exe, bool trace=true){
+    string cfile = exe + ".c";
+    {
+        ofstream out(cfile);
+        if(!out){
+            cerr<<"[NATIVE ERROR] Cannot write "<<cfile<<"\n";
+            return false;
+        }
+        emitC(tac, out);
+    }
+    const char *cc = getenv("CC");
+    string cmd = string(cc && *cc ? cc : "cc") + " -O2 -fwrapv" + (trace ? "" : " -w") + " -o '" + exe + "' '" + cfile + "'";
+    if(trace) cout << "[NATIVE] " << cmd << endl;
+    int rc = system(cmd.c_str());
+    remove(cfile.c_str());
+    if(rc != 0){
+        cerr<<"[NATIVE ERROR] C compiler failed\n";
+        return false;
+    }
+    return true;
+}
 
-// Expression Nodes
-struct IntLit : Expr { 
-    long long v; 
-    IntLit(long long vv): v(vv){} 
-    long long eval(map<string,long long>&) override { return v; } 
-    string toString() const override { return "IntLit(" + to_string(v) + ")"; }
+// ============================================================================
+// PHASE 6: CODE GENERATION & EXECUTION
+// ============================================================================
+struct RunOptions {
+    bool verbose = false;   // -v: show TAC (and bytecode with --vm)
+    bool debug = false;     // -d: trace every phase
+    bool useVM = false;     // --vm: execute on the bytecode VM instead of the AST
+    bool tiered = false;    // --jit: interpret the TAC, compiling hot loops to native code
+    string emitCPath;       // --emit-c FILE: write the program as C and stop
+    string nativeOut;       // --native -o FILE: build a standalone executable and stop
+    int optLevel = 0;       // -O0/-O1/-O2: SSA passes over the TAC
+    bool countInstrs = false; // --count: interpret the TAC without the JIT and report instructions executed
+    bool lexBench = false;  // --bench-lexer: only tokenize the source and report throughput
+    bool stream = false;    // --stream: run each top-level statement as soon as it is parsed
+    bool quiet = false;     // --quiet: stdout carries program output only (no banners or traces)
+    bool profile = false;   // --profile: time each phase and count statement executions (stderr)
+    string profileJson;     // --profile-json FILE: also write the profile as JSON
+    string cacheDir;        // --cache DIR: reuse compiled programs stored there as .mlc files
+    bool bigint = false;    // --bigint: arbitrary-precision values (AST interpreter only)
+    size_t loopThreads = 1; // -j N: threads for independent loop iterations (AST interpreter)
+    bool simd = true;       // --no-simd: run straight-line loop bodies one iteration at a time
 };
 
-struct VarExpr : Expr { 
-    string name; 
-    VarExpr(const string &n): name(n){} 
-    long long eval(map<string,long long>&env) override { 
-        if(env.find(name)==env.end()){ 
-            cerr<<"[RUNTIME ERROR] Use of undefined variable '"<<name<<"'\n"; 
-            exit(1);
-        } 
-        return env[name]; 
-    } 
-    string toString() const override { return "VarExpr(" + name + ")"; }
+// Tokenizes the whole source a few times and reports the best pass, so
+// lexer changes can be tracked in MB/s independently of the later phases.
+bool benchLexer(string_view source){
+    const int passes = 5;
+    size_t tokens = 0;
+    double best = 1e300;
+    for(int pass = 0; pass < passes; pass++){
+        auto start = chrono::steady_clock::now();
+        Lexer lex(source);
+        size_t n = 0;
+        while(lex.nextToken().type != TokenType::END) n++;
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        tokens = n;
+    }
+    cout << "[STATS] Lexed " << tokens << " tokens from " << source.size() << " bytes in "
+         << fixed << setprecision(1) << best * 1e3 << " ms (best of " << passes << "): "
+         << source.size() / 1e6 / max(best, 1e-9) << " MB/s" << endl;
+    return true;
+}
+
+// ============================================================================
+// COMPILED PROGRAM CACHE (--cache)
+// ============================================================================
+// A .mlc file holds the program an engine executes, TAC for --jit/--count
+// or bytecode for --vm, as the arrays the executors read.  All sections are
+// addressed by offsets from the start of the file and aligned to 8 bytes, so
+// a mapping of the file is run in place.  The file name is a hash of the
+// compiler build, the engine and the source; the header repeats it, and any
+// file that fails the checks in loadMlc is treated as a miss.
+static constexpr uint32_t MLC_VERSION = 1;
+static const char MLC_BUILD[] = __DATE__ " " __TIME__;
+
+struct MlcHeader {
+    char magic[4];              // "MLC\0"
+    uint32_t version;           // MLC_VERSION
+    uint64_t key;               // mlcKey() of the source
+    uint64_t sourceSize;
+    uint32_t engine;            // cacheEngine()
+    uint32_t numNames;          // variable names, NUL-terminated, in slot order
+    uint64_t namesOffset, namesSize;
+    uint64_t constsOffset;      // long long[numConsts]
+    uint32_t numConsts;
+    uint32_t count;             // instructions
+    uint64_t codeOffset;        // bytecode: Instr[count]; TAC: TACOp[count]
+    uint64_t dstOffset, aOffset, bOffset;   // TAC: TACId[count] each
+    uint32_t numTemps;          // TAC
+    int32_t numRegs;            // bytecode
+    uint64_t checksum;          // mlcHash() of everything after the header
 };
 
-struct Binary : Expr { 
-    string op; 
-    unique_ptr<Expr> a,b; 
-    Binary(const string &op_, unique_ptr<Expr> a_, unique_ptr<Expr> b_): op(op_), a(move(a_)), b(move(b_)){} 
-    
-    long long eval(map<string,long long>&env) override { 
-        long long A=a->eval(env), B=b->eval(env); 
-        if(op=="+") return A+B; 
-        if(op=="-") return A-B; 
-        if(op=="*") return A*B; 
-        if(op=="/"){ 
-            if(B==0){ 
-                cerr<<"[RUNTIME ERROR] Division by zero\n"; 
-                exit(1);
-            } 
-            return A/B; 
-        } 
-        if(op=="%") return A%B; 
-        if(op=="==") return A==B; 
-        if(op=="!=") return A!=B; 
-        if(op=="<") return A<B; 
-        if(op==">") return A>B; 
-        if(op=="<=") return A<=B; 
-        if(op==">=") return A>=B; 
-        cerr<<"[RUNTIME ERROR] Unknown operator "<<op<<"\n"; 
-        exit(1); 
-    } 
-    
-    string toString() const override { 
-        return "Binary(" + op + ", " + a->toString() + ", " + b->toString() + ")"; 
+// FNV-1a over 8-byte words: quick enough to check a whole file on load.
+uint64_t mlcHash(string_view bytes, uint64_t h = 14695981039346656037ull){
+    size_t k = 0;
+    for(; k + 8 <= bytes.size(); k += 8){
+        uint64_t w;
+        memcpy(&w, bytes.data() + k, 8);
+        h = (h ^ w) * 1099511628211ull;
+        h ^= h >> 29;
     }
-};
+    for(; k < bytes.size(); k++) h = (h ^ (unsigned char)bytes[k]) * 1099511628211ull;
+    return h;
+}
 
-// Statement Nodes
-struct PrintStmt : Stmt { 
-    unique_ptr<Expr> e; 
-    PrintStmt(unique_ptr<Expr> e_): e(move(e_)){} 
-    void exec(map<string,long long>&env) override { 
-        cout << e->eval(env) << "\n"; 
-    } 
-    string toString() const override { 
-        return "PrintStmt(" + e->toString() + ")"; 
+// 'v' for bytecode, '0'..'2' for TAC at that -O level, 0 when the engine
+// runs the AST and there is nothing to cache.
+char cacheEngine(const RunOptions &opts){
+    if(opts.tiered || opts.countInstrs) return '0' + opts.optLevel;
+    return opts.useVM ? 'v' : 0;
+}
+
+uint64_t mlcKey(string_view source, char engine){
+    return mlcHash(source, mlcHash(string_view(&engine, 1), mlcHash(MLC_BUILD)));
+}
+
+string mlcPath(const string &dir, uint64_t key){
+    char name[24];
+    snprintf(name, sizeof name, "%016llx.mlc", (unsigned long long)key);
+    return dir + "/" + name;
+}
+
+// Writes through a temporary file and rename(), so concurrent runs never see
+// a partial file.  Failures only cost the cache entry.
+void saveMlc(const RunOptions &opts, string_view source, const TACProgram &tac, const Bytecode &bc){
+#ifdef MINILANG_HAVE_POSIX
+    char engine = cacheEngine(opts);
+    if(!engine) return;
+    MlcHeader h{};
+    memcpy(h.magic, "MLC", 4);
+    h.version = MLC_VERSION;
+    h.key = mlcKey(source, engine);
+    h.sourceSize = source.size();
+    h.engine = engine;
+    string file(sizeof h, '\0');
+    auto section = [&](const void *data, size_t bytes){
+        file.resize((file.size() + 7) & ~size_t(7), '\0');
+        size_t at = file.size();
+        file.append(static_cast<const char*>(data), bytes);
+        return at;
+    };
+    string names;
+    for(const string &n : tac.slots->names) names.append(n.c_str(), n.size() + 1);
+    h.numNames = tac.slots->size();
+    h.namesSize = names.size();
+    h.namesOffset = section(names.data(), names.size());
+    if(engine == 'v'){
+        h.numConsts = bc.constants.size();
+        h.constsOffset = section(bc.constants.data(), bc.constants.size() * sizeof(long long));
+        h.count = bc.code.size();
+        h.codeOffset = section(bc.code.data(), bc.code.size() * sizeof(Instr));
+        h.numRegs = bc.numRegs;
+    } else {
+        h.numConsts = tac.numConsts;
+        h.constsOffset = section(tac.consts, tac.numConsts * sizeof(long long));
+        h.count = tac.count;
+        h.codeOffset = section(tac.op, tac.count * sizeof(TACOp));
+        h.dstOffset = section(tac.dst, tac.count * sizeof(TACId));
+        h.aOffset = section(tac.a, tac.count * sizeof(TACId));
+        h.bOffset = section(tac.b, tac.count * sizeof(TACId));
+        h.numTemps = tac.numTemps;
     }
-};
+    h.checksum = mlcHash(string_view(file).substr(sizeof h));
+    memcpy(&file[0], &h, sizeof h);
 
-struct AssignStmt : Stmt { 
-    string name; 
-    unique_ptr<Expr> e; 
-    AssignStmt(const string &n, unique_ptr<Expr> e_): name(n), e(move(e_)){} 
-    void exec(map<string,long long>&env) override { 
-        long long val = e->eval(env); 
-        env[name]=val; 
-    } 
-    string toString() const override { 
-        return "AssignStmt(" + name + ", " + e->toString() + ")"; 
+    string path = mlcPath(opts.cacheDir, h.key);
+    string tmp = path + ".XXXXXX";
+    int fd = mkstemp(&tmp[0]);
+    if(fd < 0){
+        cerr<<"[CACHE] Cannot write to "<<opts.cacheDir<<": "<<strerror(errno)<<"\n";
+        return;
     }
-};
+    bool ok = fchmod(fd, 0644) == 0;     // mkstemp creates it private
+    for(size_t done = 0; ok && done < file.size(); ){
+        ssize_t n = write(fd, file.data() + done, file.size() - done);
+        if(n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        done += max<ssize_t>(n, 0);
+    }
+    ok = close(fd) == 0 && ok;
+    if(!ok || rename(tmp.c_str(), path.c_str()) != 0) unlink(tmp.c_str());
+#else
+    (void)opts; (void)source; (void)tac; (void)bc;
+#endif
+}
 
-struct BlockStmt : Stmt { 
-    vector<unique_ptr<Stmt>> stmts; 
-    void exec(map<string,long long>&env) override { 
-        for(auto &s: stmts) s->exec(env); 
-    } 
-    string toString() const override { 
-        string result = "BlockStmt[\n";
-        for(auto &s: stmts) result += "  " + s->toString() + "\n";
-        return result + "]";
-    }
-};
-
-struct IfStmt : Stmt { 
-    unique_ptr<Expr> cond; 
-    unique_ptr<BlockStmt> thenBlock; 
-    unique_ptr<BlockStmt> elseBlock; 
-    IfStmt(unique_ptr<Expr> c, unique_ptr<BlockStmt> t, unique_ptr<BlockStmt> e): 
-        cond(move(c)), thenBlock(move(t)), elseBlock(move(e)){} 
-    void exec(map<string,long long>&env) override { 
-        if(cond->eval(env)) thenBlock->exec(env); 
-        else if(elseBlock) elseBlock->exec(env); 
-    } 
-    string toString() const override { 
-        string result = "IfStmt(" + cond->toString() + ",\n  THEN: " + thenBlock->toString();
-        if(elseBlock) result += ",\n  ELSE: " + elseBlock->toString();
-        return result + ")";
+// A mapped .mlc file.  `tac` borrows its arrays from the mapping (it is only
+// ever read), and `slots` holds the variable names it refers to.
+struct MlcImage {
+    void *mapping = nullptr;
+    size_t size = 0;
+    const MlcHeader *h = nullptr;
+    SlotTable slots;
+    TACProgram tac{&slots};
+
+    MlcImage() = default;
+    MlcImage(const MlcImage&) = delete;
+    MlcImage &operator=(const MlcImage&) = delete;
+    ~MlcImage(){
+#ifdef MINILANG_HAVE_POSIX
+        if(mapping) munmap(mapping, size);
+#endif
     }
-};
 
-struct WhileStmt : Stmt { 
-    unique_ptr<Expr> cond; 
-    unique_ptr<BlockStmt> body; 
-    WhileStmt(unique_ptr<Expr> c, unique_ptr<BlockStmt> b): cond(move(c)), body(move(b)){} 
-    void exec(map<string,long long>&env) override { 
-        while(cond->eval(env)) body->exec(env); 
-    } 
-    string toString() const override { 
-        return "WhileStmt(" + cond->toString() + ", " + body->toString() + ")"; 
+    template<class T> const T *at(uint64_t offset) const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(mapping) + offset);
+    }
+    bool fits(uint64_t offset, uint64_t bytes) const {
+        return offset % 8 == 0 && offset <= size && bytes <= size - offset;
+    }
+
+    // The checksum matches, and every section lies inside the file and every
+    // operand, register and jump target is in range, so a stale or damaged
+    // file cannot misbehave.
+    bool valid(string_view source, char engine) const {
+        if(memcmp(h->magic, "MLC", 4) || h->version != MLC_VERSION || h->engine != (uint32_t)engine ||
+           h->sourceSize != source.size() || h->key != mlcKey(source, engine)) return false;
+        if(h->checksum != mlcHash(string_view(at<char>(sizeof *h), size - sizeof *h))) return false;
+        if(!fits(h->namesOffset, h->namesSize) || !fits(h->constsOffset, uint64_t(h->numConsts) * sizeof(long long))) return false;
+        if(engine == 'v'){
+            if(!fits(h->codeOffset, uint64_t(h->count) * sizeof(Instr))) return false;
+            int64_t regs = h->numRegs;
+            if(regs < int64_t(h->numNames) + h->numConsts || regs > int64_t(h->numNames) + h->numConsts + h->count + 1) return false;
+            const Instr *code = at<Instr>(h->codeOffset);
+            if(h->count == 0 || code[h->count - 1].op != Op::HALT) return false;
+            auto reg = [&](int32_t r){ return r >= 0 && r < regs; };
+            for(uint32_t pc = 0; pc < h->count; pc++){
+                const Instr &in = code[pc];
+                if(uint32_t(in.op) > uint32_t(Op::HALT)) return false;
+                if(in.op == Op::HALT) continue;
+                bool jump = in.op >= Op::JMP;
+                if(jump ? (in.dst < 0 || uint32_t(in.dst) >= h->count) : (in.op != Op::PRINT && !reg(in.dst))) return false;
+                if(in.op != Op::JMP && !reg(in.a)) return false;
+                if((in.op <= Op::GTE || in.op > Op::JZ) && !reg(in.b)) return false;
+            }
+            return true;
+        }
+        uint64_t arrays = uint64_t(h->count) * sizeof(TACId);
+        if(!fits(h->codeOffset, h->count) || !fits(h->dstOffset, arrays) || !fits(h->aOffset, arrays) || !fits(h->bOffset, arrays))
+            return false;
+        const TACOp *op = at<TACOp>(h->codeOffset);
+        const TACId *ids[3] = { at<TACId>(h->dstOffset), at<TACId>(h->aOffset), at<TACId>(h->bOffset) };
+        // Unused operands are 0; an operand the instruction reads must name
+        // a value, and a destination must be a variable or temporary.
+        for(uint32_t pc = 0; pc < h->count; pc++){
+            if(uint32_t(op[pc]) > uint32_t(TACOp::GOTO)) return false;
+            bool jump = op[pc] == TACOp::IFZ || op[pc] == TACOp::GOTO;
+            if(jump && ids[0][pc] > h->count) return false;
+            bool used[3] = { !jump && op[pc] != TACOp::PRINT, op[pc] != TACOp::GOTO, isBinaryTAC(op[pc]) };
+            for(int k = jump ? 1 : 0; k < 3; k++){
+                uint32_t index = TACProgram::index(ids[k][pc]);
+                switch(TACProgram::kind(ids[k][pc])){
+                    case TACProgram::VAR:   if(index >= h->numNames) return false; break;
+                    case TACProgram::TEMP:  if(index > h->numTemps) return false; break;
+                    case TACProgram::CONST: if(index >= h->numConsts || k == 0) return false; break;
+                    case TACProgram::NONE:  if(ids[k][pc] != 0 || used[k]) return false; break;
+                }
+            }
+        }
+        return true;
     }
 };
 
-// ============================================================================
-// PHASE 2: SYNTAX ANALYSIS - Parser Implementation
-// ============================================================================
-struct Parser {
-    Lexer lex; 
-    Token cur; 
-    bool debug;
+// Maps the cached program for `source`, if there is a usable one.
+bool loadMlc(const RunOptions &opts, string_view source, MlcImage &img){
+#ifdef MINILANG_HAVE_POSIX
+    char engine = cacheEngine(opts);
+    int fd = open(mlcPath(opts.cacheDir, mlcKey(source, engine)).c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    bool mapped = fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(MlcHeader) &&
+        (img.mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED;
+    close(fd);
+    if(!mapped){
+        img.mapping = nullptr;
+        return false;
+    }
+    img.size = st.st_size;
+    img.h = img.at<MlcHeader>(0);
+    if(!img.valid(source, engine)) return false;
+    const MlcHeader &h = *img.h;
+    const char *name = img.at<char>(h.namesOffset), *end = name + h.namesSize;
+    for(uint32_t k = 0; k < h.numNames; k++){
+        const char *stop = static_cast<const char*>(memchr(name, '\0', end - name));
+        if(!stop) return false;
+        img.slots.names.emplace_back(name, stop);
+        name = stop + 1;
+    }
+    if(engine != 'v'){
+        TACProgram &t = img.tac;
+        t.op = const_cast<TACOp*>(img.at<TACOp>(h.codeOffset));
+        t.dst = const_cast<TACId*>(img.at<TACId>(h.dstOffset));
+        t.a = const_cast<TACId*>(img.at<TACId>(h.aOffset));
+        t.b = const_cast<TACId*>(img.at<TACId>(h.bOffset));
+        t.consts = const_cast<long long*>(img.at<long long>(h.constsOffset));
+        t.count = t.capacity = h.count;
+        t.numConsts = t.constCapacity = h.numConsts;
+        t.numTemps = h.numTemps;
+    }
+    return true;
+#else
+    (void)opts; (void)source; (void)img;
+    return false;
+#endif
+}
+
+// Runs the cached program for `source` and returns true, or returns false
+// on a miss so the caller compiles it.
+bool runCached(string_view source, const RunOptions &opts){
+    MlcImage img;
+    if(!loadMlc(opts, source, img)) return false;
+    bool quiet = opts.quiet;
+    if(!quiet){
+        cout << "=== MINILANG COMPILER EXECUTION ===" << endl;
+        cout << "[CACHE] Running " << (img.h->engine == 'v' ? "bytecode" : "TAC") << " from "
+             << mlcPath(opts.cacheDir, img.h->key) << endl;
+        cout << "\n--- PHASE 6: EXECUTION ---" << endl;
+        cout << "Program Output:" << endl;
+        cout << "---------------" << endl;
+    }
+    uint64_t executed = 0, multiplies = 0;
+    if(img.h->engine == 'v'){
+        const MlcHeader &h = *img.h;
+        runBytecode(img.at<Instr>(h.codeOffset), img.at<long long>(h.constsOffset), h.numConsts, h.numNames, h.numRegs);
+    } else {
+        TieredExecutor tier(img.tac, opts.debug);
+        tier.jitEnabled = !opts.countInstrs;
+        tier.run();
+        for(int k = 0; k < 16; k++) executed += tier.executed[k];
+        multiplies = tier.executed[(int)TACOp::MUL];
+    }
+    programOut.flush();
+    if(!quiet){
+        cout << "---------------" << endl;
+        cout << "Execution completed!" << endl;
+    }
+    if(opts.countInstrs)
+        (quiet ? cerr : cout) << "[STATS] Executed " << executed << " TAC instructions (" << multiplies << " multiplications)" << endl;
+    return true;
+}
+
+bool runSource(string_view source, const RunOptions &opts){
+    bool verbose = opts.verbose, debug = opts.debug, quiet = opts.quiet;
+    if(!quiet) cout << "=== MINILANG COMPILER EXECUTION ===" << endl;
+    Profiler profiler;
+    Profiler *prof = opts.profile ? &profiler : nullptr;
     
-    Parser(const string &s, bool dbg=false): lex(s, dbg), debug(dbg) { 
-        cur = lex.nextToken(); 
-        if(debug) cout << "[PARSER] Initialized, first token: " << tokenTypeName(cur.type) << endl;
+    // PHASE 1: Lexical Analysis
+    if(!quiet) cout << "\n--- PHASE 1: LEXICAL ANALYSIS ---" << endl;
+    if(prof) prof->phase("parse");     // the parser pulls tokens, so lexing is timed with it
+    Parser p(source, debug, opts.bigint);
+    
+    // PHASE 2: Syntax Analysis  
+    if(!quiet) cout << "\n--- PHASE 2: SYNTAX ANALYSIS ---" << endl;
+    Ast ast = p.parseProgram();
+    
+    // PHASE 3: Semantic Analysis
+    if(!quiet) cout << "\n--- PHASE 3: SEMANTIC ANALYSIS ---" << endl;
+    const SlotTable &slots = ast.names;
+    if(prof) prof->phase("semantic");
+    vector<bool> defined(slots.size(), false);
+    semanticCheckBlock(ast, ast.root, defined, !quiet, debug);
+    if(debug) cout << "[SEMANTIC] Resolved " << slots.size() << " variable slots" << endl;
+    
+    // PHASE 5: Optimization
+    if(!quiet) cout << "\n--- PHASE 5: OPTIMIZATION ---" << endl;
+    if(prof) prof->phase("fold");
+    foldConstantsInBlock(ast, ast.root, !quiet, opts.bigint);
+
+    // Loops whose iterations are independent, for the AST interpreter.
+    ParallelLoops loops;
+    bool astEngine = !opts.bigint && !opts.useVM && !opts.tiered && !opts.countInstrs && !prof
+                     && opts.emitCPath.empty() && opts.nativeOut.empty();
+    if(astEngine && (opts.loopThreads > 1 || opts.simd)){
+        loops.threads = opts.loopThreads;
+        loops.simd = opts.simd;
+        loops.analyze(ast, ast.root, !quiet);
     }
     
-    void eat(TokenType t){ 
-        if(cur.type==t) {
-            if(debug) cout << "[PARSER] Consumed token: " << tokenTypeName(t) << endl;
-            cur = lex.nextToken(); 
-        } else { 
-            cerr<<"[PARSER ERROR] Line " << cur.line << ": expected "<<tokenTypeName(t)<<" but got "<<tokenTypeName(cur.type)<<" ('"<<cur.text<<"')\n"; 
-            exit(1); 
-        } 
+    // PHASE 4 & 6: Intermediate Code Generation.  TAC holds 64-bit values,
+    // so --bigint goes straight to the AST interpreter.
+    TACGen gen(slots, debug); 
+    if(!opts.bigint){
+        if(!quiet) cout << "\n--- PHASE 4 & 6: INTERMEDIATE CODE GENERATION ---" << endl;
+        if(prof) prof->phase("tacgen");
+        gen.genProgram(ast);
     }
     
-    unique_ptr<BlockStmt> parseProgram(){ 
-        if(debug) cout << "[PARSER] Starting program parsing" << endl;
-        auto root = make_unique<BlockStmt>(); 
-        while(cur.type!=TokenType::END) {
-            root->stmts.push_back(parseStatement());
-        }
-        if(debug) {
-            cout << "[PARSER] Program parsing complete. AST:" << endl;
-            cout << root->toString() << endl;
-        }
-        return root; 
+    if(opts.optLevel > 0){
+        if(!quiet) cout << "\n--- PHASE 5: SSA OPTIMIZATION (-O" << opts.optLevel << ") ---" << endl;
+        if(prof) prof->phase("optimize");
+        optimizeTAC(gen.prog, opts.optLevel, debug, !quiet);
     }
     
-    unique_ptr<Stmt> parseStatement(){
-        if(debug) cout << "[PARSER] Parsing statement, current token: " << tokenTypeName(cur.type) << endl;
-        
-        if(cur.type==TokenType::KW_PRINT){ 
-            if(debug) cout << "[PARSER] Found print statement" << endl;
-            eat(TokenType::KW_PRINT); 
-            eat(TokenType::LPAREN); 
-            auto e=parseExpr(); 
-            eat(TokenType::RPAREN); 
-            eat(TokenType::SEMI); 
-            return make_unique<PrintStmt>(move(e)); 
-        }
-        if(cur.type==TokenType::IDENT){ 
-            string name=cur.text; 
-            if(debug) cout << "[PARSER] Found assignment to variable: " << name << endl;
-            eat(TokenType::IDENT); 
-            eat(TokenType::ASSIGN); 
-            auto e=parseExpr(); 
-            eat(TokenType::SEMI); 
-            return make_unique<AssignStmt>(name, move(e)); 
-        }
-        if(cur.type==TokenType::KW_IF){ 
-            if(debug) cout << "[PARSER] Found if statement" << endl;
-            eat(TokenType::KW_IF); 
-            eat(TokenType::LPAREN); 
-            auto cond=parseExpr(); 
-            eat(TokenType::RPAREN); 
-            auto thenB=parseBlock(); 
-            unique_ptr<BlockStmt> elseB=nullptr; 
-            if(cur.type==TokenType::KW_ELSE){ 
-                if(debug) cout << "[PARSER] Found else clause" << endl;
-                eat(TokenType::KW_ELSE); 
-                elseB=parseBlock(); 
-            } 
-            return make_unique<IfStmt>(move(cond), move(thenB), move(elseB)); 
-        }
-        if(cur.type==TokenType::KW_WHILE){ 
-            if(debug) cout << "[PARSER] Found while statement" << endl;
-            eat(TokenType::KW_WHILE); 
-            eat(TokenType::LPAREN); 
-            auto cond=parseExpr(); 
-            eat(TokenType::RPAREN); 
-            auto body=parseBlock(); 
-            return make_unique<WhileStmt>(move(cond), move(body)); 
+    if(prof) prof->phase(nullptr);
+    if(verbose && !opts.bigint){ 
+        cout << "\n--- THREE ADDRESS CODE ---" << endl;
+        gen.prog.print(cout); 
+        cout << "--- END TAC ---" << endl;
+    }
+    
+    if(!opts.emitCPath.empty() || !opts.nativeOut.empty()){
+        if(!quiet) cout << "\n--- PHASE 6: NATIVE CODE GENERATION ---" << endl;
+        if(prof) prof->phase("native");
+        if(!opts.emitCPath.empty()){
+            ofstream out(opts.emitCPath);
+            if(!out){
+                cerr<<"[NATIVE ERROR] Cannot write "<<opts.emitCPath<<"\n";
+                return false;
+            }
+            emitC(gen.prog, out);
+            if(!quiet) cout << "[NATIVE] Wrote C translation to " << opts.emitCPath << endl;
         }
-        if(cur.type==TokenType::LBRACE) {
-            if(debug) cout << "[PARSER] Found block statement" << endl;
-            return parseBlock();
+        if(!opts.nativeOut.empty()){
+            if(!buildNative(gen.prog, opts.nativeOut, !quiet)) return false;
+            if(!quiet) cout << "[NATIVE] Built executable " << opts.nativeOut << endl;
         }
-        cerr<<"[PARSER ERROR] Unexpected token "<<tokenTypeName(cur.type)<<" ('"<<cur.text<<"')\n"; 
-        exit(1);
+        if(prof) prof->report(ast, cerr, opts.profileJson);
+        return true;
     }
     
-    unique_ptr<BlockStmt> parseBlock(){ 
-        eat(TokenType::LBRACE); 
-        auto blk=make_unique<BlockStmt>(); 
-        while(cur.type!=TokenType::RBRACE) {
-            blk->stmts.push_back(parseStatement());
+    Bytecode bc;
+    if(opts.useVM){
+        if(prof) prof->phase("bytecode");
+        BytecodeCompiler bcc(ast, debug);
+        bc = bcc.compile();
+        if(verbose){
+            cout << "\n--- BYTECODE ---" << endl;
+            bc.dump(cout);
+            cout << "--- END BYTECODE ---" << endl;
         }
-        eat(TokenType::RBRACE); 
-        return blk; 
     }
     
-    unique_ptr<Expr> parseExpr(){ return parseEquality(); }
-    
-    unique_ptr<Expr> parseEquality(){ 
-        auto left=parseComparison(); 
-        while(cur.type==TokenType::EQ||cur.type==TokenType::NEQ){ 
-            string op=cur.text; 
-            if(debug) cout << "[PARSER] Equality operator: " << op << endl;
-            eat(cur.type); 
-            auto right=parseComparison(); 
-            left=make_unique<Binary>(op, move(left), move(right)); 
-        } 
-        return left; 
+    if(!opts.cacheDir.empty()) saveMlc(opts, source, gen.prog, bc);
+
+    // PHASE 6: Execution
+    if(!quiet){
+        cout << "\n--- PHASE 6: EXECUTION ---" << endl;
+        cout << "Program Output:" << endl;
+        cout << "---------------" << endl;
     }
-    
-    unique_ptr<Expr> parseComparison(){ 
-        auto left=parseTerm(); 
-        while(cur.type==TokenType::LT||cur.type==TokenType::GT||cur.type==TokenType::LTE||cur.type==TokenType::GTE){ 
-            string op=cur.text; 
-            if(debug) cout << "[PARSER] Comparison operator: " << op << endl;
-            eat(cur.type); 
-            auto right=parseTerm(); 
-            left=make_unique<Binary>(op, move(left), move(right)); 
-        } 
-        return left; 
+    uint64_t executed = 0, multiplies = 0;
+    if(prof) prof->phase("execute");
+    if(opts.bigint){
+        BasicFrame<Num> env(slots.size());
+        if(prof){
+            prof->attach(ast);
+            AstInterpreter<true, Num>(ast, env, prof).exec(ast.root);
+        } else AstInterpreter<false, Num>(ast, env).exec(ast.root);
+    } else if(opts.useVM && !opts.countInstrs){
+        runBytecode(bc);
+    } else if(opts.tiered || opts.countInstrs){
+        TieredExecutor tier(gen.prog, debug);
+        tier.jitEnabled = !opts.countInstrs;
+        tier.run();
+        for(int k = 0; k < 16; k++) executed += tier.executed[k];
+        multiplies = tier.executed[(int)TACOp::MUL];
+    } else if(prof){
+        Frame env(slots.size());
+        prof->attach(ast);
+        AstInterpreter<true>(ast, env, prof).exec(ast.root);
+    } else {
+        Frame env(slots.size());
+        AstInterpreter interp(ast, env);
+        if(!loops.plans.empty()) interp.loops = &loops;
+        interp.exec(ast.root);
     }
-    
-    unique_ptr<Expr> parseTerm(){ 
-        auto left=parseFactor(); 
-        while(cur.type==TokenType::PLUS||cur.type==TokenType::MINUS){ 
-            string op=cur.text; 
-            if(debug) cout << "[PARSER] Term operator: " << op << endl;
-            eat(cur.type); 
-            auto right=parseFactor(); 
-            left=make_unique<Binary>(op, move(left), move(right)); 
-        } 
-        return left; 
+    programOut.flush();
+    if(prof) prof->phase(nullptr);
+    if(!quiet){
+        cout << "---------------" << endl;
+        cout << "Execution completed!" << endl;
     }
-    
-    unique_ptr<Expr> parseFactor(){ 
-        auto left=parseUnary(); 
-        while(cur.type==TokenType::MUL||cur.type==TokenType::DIV||cur.type==TokenType::MOD){ 
-            string op=cur.text; 
-            if(debug) cout << "[PARSER] Factor operator: " << op << endl;
-            eat(cur.type); 
-            auto right=parseUnary(); 
-            left=make_unique<Binary>(op, move(left), move(right)); 
-        } 
-        return left; 
+    // Statistics stay off stdout in quiet mode, which carries program output only.
+    if(opts.countInstrs)
+        (quiet ? cerr : cout) << "[STATS] Executed " << executed << " TAC instructions (" << multiplies << " multiplications)" << endl;
+    if(prof) prof->report(ast, cerr, opts.profileJson);
+    return true;
+}
+
+// Streaming execution: each top-level statement is parsed, checked against
+// the variables defined so far, folded and executed, and then its nodes are
+// discarded.  Memory is bounded by the largest top-level statement (plus one
+// slot per distinct variable) instead of by the size of the program.  A
+// semantic error therefore stops the program only when its statement is
+// reached, after the output of everything before it.
+template<class Value> bool runStreamAs(StreamSource &source, const RunOptions &opts){
+    bool debug = opts.debug, quiet = opts.quiet;
+    if(!quiet) cout << "=== MINILANG STREAMING EXECUTION ===" << endl;
+    Parser p(source, debug, opts.bigint);
+    BasicFrame<Value> env;
+    AstInterpreter<false, Value> interp(p.ast, env);   // keeps its stacks across statements
+    ConstantFolder folder(p.ast, debug);               // and its constants
+    folder.exact = opts.bigint;
+    vector<bool> defined;
+    size_t statements = 0, largest = 0;
+    if(!quiet){
+        cout << "Program Output:" << endl;
+        cout << "---------------" << endl;
     }
-    
-    unique_ptr<Expr> parseUnary(){ 
-        if(cur.type==TokenType::PLUS){ 
-            if(debug) cout << "[PARSER] Unary plus" << endl;
-            eat(TokenType::PLUS); 
-            return parseUnary(); 
-        } else if(cur.type==TokenType::MINUS){ 
-            if(debug) cout << "[PARSER] Unary minus" << endl;
-            eat(TokenType::MINUS); 
-            auto r=parseUnary(); 
-            return make_unique<Binary>(string("-"), make_unique<IntLit>(0), move(r)); 
-        } else return parsePrimary(); 
+    for(NodeId blk; (blk = p.parseTopLevel()) != NO_NODE; p.ast.clearNodes()){
+        size_t slots = p.ast.names.size();
+        defined.resize(slots, false);
+        env.slots.resize(slots, 0);
+        env.init.resize(slots, false);
+        semanticCheckBlock(p.ast, blk, defined, debug, debug);
+        folder.run(blk);
+        interp.exec(blk);
+        statements++;
+        largest = max(largest, p.ast.nodes.size());
     }
-    
-    unique_ptr<Expr> parsePrimary(){ 
-        if(cur.type==TokenType::INT_LIT){ 
-            long long v=cur.intVal; 
-            if(debug) cout << "[PARSER] Integer literal: " << v << endl;
-            eat(TokenType::INT_LIT); 
-            return make_unique<IntLit>(v); 
-        } else if(cur.type==TokenType::IDENT){ 
-            string name=cur.text; 
-            if(debug) cout << "[PARSER] Variable: " << name << endl;
-            eat(TokenType::IDENT); 
-            return make_unique<VarExpr>(name); 
-        } else if(cur.type==TokenType::LPAREN){ 
-            if(debug) cout << "[PARSER] Parenthesized expression" << endl;
-            eat(TokenType::LPAREN); 
-            auto e=parseExpr(); 
-            eat(TokenType::RPAREN); 
-            return e; 
-        } 
-        cerr<<"[PARSER ERROR] Unexpected primary token\n"; 
-        exit(1); 
+    programOut.flush();
+    if(!quiet){
+        cout << "---------------" << endl;
+        cout << "Execution completed!" << endl;
+        cout << "[STATS] Streamed " << statements << " top-level statements, at most " << largest
+             << " AST nodes held at once" << endl;
+    }
+    return true;
+}
+
+bool runStream(StreamSource &source, const RunOptions &opts){
+    return opts.bigint ? runStreamAs<Num>(source, opts) : runStreamAs<long long>(source, opts);
+}
+
+// Source text of a program file.  The file is mapped read-only where mmap
+// is available, so tokens slice straight into the page cache; elsewhere it
+// is read into `copy` in one go.
+struct SourceFile {
+    string_view text;
+    string copy;
+    void *mapping = nullptr;
+    size_t mappedSize = 0;
+
+    SourceFile() = default;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile &operator=(const SourceFile&) = delete;
+    ~SourceFile(){
+#ifdef MINILANG_HAVE_POSIX
+        if(mapping) munmap(mapping, mappedSize);
+#endif
     }
 };
 
-// ============================================================================
-// PHASE 3: SEMANTIC ANALYSIS
-// ============================================================================
-void semanticCheckBlock(BlockStmt* blk, set<string>& defined, int depth=0){
-    string indent(depth*2, ' ');
-    if(depth == 0) cout << "[SEMANTIC] Starting semantic analysis..." << endl;
-    
-    for(auto &s: blk->stmts){
-        if(auto as = dynamic_cast<AssignStmt*>(s.get())){
-            cout << indent << "[SEMANTIC] Checking assignment to: " << as->name << endl;
-            
-            function<void(Expr*)> findVars = [&](Expr* e){ 
-                if(!e) return; 
-                if(auto ve = dynamic_cast<VarExpr*>(e)){ 
-                    if(defined.find(ve->name)==defined.end()){ 
-                        cerr<<"[SEMANTIC ERROR] Variable '"<<ve->name<<"' used before assignment\n"; 
-                        exit(1);
-                    } else {
-                        cout << indent << "[SEMANTIC] Valid use of variable: " << ve->name << endl;
-                    }
-                } else if(auto b = dynamic_cast<Binary*>(e)){ 
-                    findVars(b->a.get()); 
-                    findVars(b->b.get()); 
-                } 
-            };
-            
-            findVars(as->e.get()); 
-            defined.insert(as->name);
-            cout << indent << "[SEMANTIC] Variable defined: " << as->name << endl;
-            
-        } else if(auto ifs = dynamic_cast<IfStmt*>(s.get())){
-            cout << indent << "[SEMANTIC] Checking if statement condition" << endl;
-            
-            function<void(Expr*)> findVars = [&](Expr* e){ 
-                if(!e) return; 
-                if(auto ve = dynamic_cast<VarExpr*>(e)){ 
-                    if(defined.find(ve->name)==defined.end()){ 
-                        cerr<<"[SEMANTIC ERROR] Variable '"<<ve->name<<"' used before assignment\n"; 
-                        exit(1);
-                    }
-                } else if(auto b = dynamic_cast<Binary*>(e)){ 
-                    findVars(b->a.get()); 
-                    findVars(b->b.get()); 
-                } 
-            };
-            
-            findVars(ifs->cond.get());
-            
-            // check then and else with copies of defined
-            set<string> thenDef = defined; 
-            cout << indent << "[SEMANTIC] Checking then block..." << endl;
-            semanticCheckBlock(ifs->thenBlock.get(), thenDef, depth+1);
-            
-            if(ifs->elseBlock){ 
-                set<string> elseDef = defined; 
-                cout << indent << "[SEMANTIC] Checking else block..." << endl;
-                semanticCheckBlock(ifs->elseBlock.get(), elseDef, depth+1); 
-            }
-            
-        } else if(auto wh = dynamic_cast<WhileStmt*>(s.get())){
-            cout << indent << "[SEMANTIC] Checking while statement condition" << endl;
-            
-            function<void(Expr*)> findVars = [&](Expr* e){ 
-                if(!e) return; 
-                if(auto ve = dynamic_cast<VarExpr*>(e)){ 
-                    if(defined.find(ve->name)==defined.end()){ 
-                        cerr<<"[SEMANTIC ERROR] Variable '"<<ve->name<<"' used before assignment\n"; 
-                        exit(1);
-                    }
-                } else if(auto b = dynamic_cast<Binary*>(e)){ 
-                    findVars(b->a.get()); 
-                    findVars(b->b.get()); 
-                } 
-            };
-            
-            findVars(wh->cond.get());
-            set<string> bodyDef = defined; 
-            cout << indent << "[SEMANTIC] Checking while loop body..." << endl;
-            semanticCheckBlock(wh->body.get(), bodyDef, depth+1);
-            
-        } else if(auto blk2 = dynamic_cast<BlockStmt*>(s.get())){
-            cout << indent << "[SEMANTIC] Checking nested block..." << endl;
-            semanticCheckBlock(blk2, defined, depth+1);
-            
-        } else if(dynamic_cast<PrintStmt*>(s.get())){
-            auto ps = static_cast<PrintStmt*>(s.get()); 
-            cout << indent << "[SEMANTIC] Checking print statement" << endl;
-            function<void(Expr*)> findVars = [&](Expr* e){ 
-                if(!e) return; 
-                if(auto ve = dynamic_cast<VarExpr*>(e)){ 
-                    if(defined.find(ve->name)==defined.end()){ 
-                        cerr<<"[SEMANTIC ERROR] Variable '"<<ve->name<<"' used before assignment\n"; 
-                        exit(1);
-                    } else {
-                        cout << indent << "[SEMANTIC] Valid use in print: " << ve->name << endl;
-                    }
-                } else if(auto b = dynamic_cast<Binary*>(e)){ 
-                    findVars(b->a.get()); 
-                    findVars(b->b.get()); 
-                } 
-            }; 
-            findVars(ps->e.get());
+void loadFile(const string &path, SourceFile &file){ 
+#ifdef MINILANG_HAVE_POSIX
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if(fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)){
+        if(st.st_size == 0){
+            close(fd);
+            file.text = string_view();
+            return;
         }
-    }
-    
-    if(depth == 0) cout << "[SEMANTIC] Semantic analysis completed successfully!" << endl;
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(p != MAP_FAILED){
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            file.mapping = p;
+            file.mappedSize = st.st_size;
+            file.text = string_view(static_cast<const char*>(p), st.st_size);
+            return;
+        }
+    } else if(fd >= 0) close(fd);
+#endif
+    ifstream in(path, ios::binary); 
+    if(!in) { 
+        errs()<<"[ERROR] Cannot open file: "<<path<<"\n"; 
+        fail();
+    } 
+    ostringstream buf;
+    buf << in.rdbuf();
+    file.copy = buf.str();
+    file.text = file.copy;
 }
 
 // ============================================================================
-// PHASE 5: OPTIMIZATION - Constant Folding
+// BATCH MODE (--batch)
 // ============================================================================
-unique_ptr<Expr> foldExpr(unique_ptr<Expr> e){
-    if(auto b = dynamic_cast<Binary*>(e.get())){
-        b->a = foldExpr(move(b->a));
-        b->b = foldExpr(move(b->b));
-        if(auto A = dynamic_cast<IntLit*>(b->a.get())){
-            if(auto B = dynamic_cast<IntLit*>(b->b.get())){
-                long long av = A->v, bv = B->v; 
-                long long r=0; 
-                bool ok=true;
-                if(b->op=="+") r = av + bv; 
-                else if(b->op=="-") r = av - bv; 
-                else if(b->op=="*") r = av * bv; 
-                else if(b->op=="/"){ if(bv==0) ok=false; else r = av / bv; } 
-                else if(b->op=="%") { if(bv==0) ok=false; else r = av % bv; } 
-                else if(b->op=="==") r = av==bv; 
-                else if(b->op=="!=") r = av!=bv; 
-                else if(b->op=="<") r = av < bv; 
-                else if(b->op==">") r = av > bv; 
-                else if(b->op=="<=") r = av <= bv; 
-                else if(b->op==">=") r = av >= bv; 
-                else ok=false;
-                
-                if(ok) {
-                    cout << "[OPTIMIZATION] Constant folded: " << av << " " << b->op << " " << bv << " = " << r << endl;
-                    return make_unique<IntLit>(r);
-                }
-            }
-        }
-        return e;
+// One program of a batch.  Its output, followed by its error if it failed,
+// is held in memory until every program before it has been written.
+struct BatchJob {
+    string path;
+    string output;
+    double ms = 0;
+    bool ok = false;
+};
+
+// Compiles and runs a job on the calling thread, with the thread's print
+// sink and error stream pointed at the job.
+void runBatchJob(BatchJob &job, const RunOptions &opts){
+    ostringstream err;
+    programOut.capture = &job.output;
+    jobErrors = &err;
+    auto start = chrono::steady_clock::now();
+    try {
+        SourceFile file;
+        loadFile(job.path, file);
+        job.ok = runSource(file.text, opts);
+    } catch(const JobFailed &){
+        job.ok = false;
     }
-    return e;
+    programOut.flush();
+    job.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    programOut.capture = nullptr;
+    jobErrors = nullptr;
+    job.output += err.str();
 }
 
-void foldConstantsInBlock(BlockStmt* blk){
-    cout << "[OPTIMIZATION] Starting constant folding..." << endl;
-    for(auto &s : blk->stmts){
-        if(auto as = dynamic_cast<AssignStmt*>(s.get())){ 
-            as->e = foldExpr(move(as->e)); 
+// Work-stealing scheduler: each worker owns a deque seeded with a contiguous
+// run of jobs and takes from its front; once it is empty the worker steals
+// from the back of another deque, so a few slow programs do not leave the
+// other threads idle.  Jobs are all known up front, so a worker that finds
+// every deque empty is done.
+struct BatchPool {
+    struct Queue {
+        mutex lock;
+        deque<size_t> jobs;
+    };
+    vector<Queue> queues;
+
+    BatchPool(size_t jobs, size_t workers): queues(workers) {
+        for(size_t w = 0; w < workers; w++)
+            for(size_t j = jobs * w / workers; j < jobs * (w + 1) / workers; j++) queues[w].jobs.push_back(j);
+    }
+
+    bool take(size_t self, size_t &job){
+        for(size_t k = 0; k < queues.size(); k++){
+            Queue &q = queues[(self + k) % queues.size()];
+            lock_guard<mutex> hold(q.lock);
+            if(q.jobs.empty()) continue;
+            if(k == 0){
+                job = q.jobs.front();
+                q.jobs.pop_front();
+            } else {
+                job = q.jobs.back();
+                q.jobs.pop_back();
+            }
+            return true;
         }
-        else if(auto ifs = dynamic_cast<IfStmt*>(s.get())){ 
-            ifs->cond = foldExpr(move(ifs->cond)); 
-            foldConstantsInBlock(ifs->thenBlock.get()); 
-            if(ifs->elseBlock) foldConstantsInBlock(ifs->elseBlock.get()); 
+        return false;
+    }
+};
+
+// Runs every .minilang file under `dir` (in path order) on `threads` worker
+// threads.  Outputs are written to stdout in that order as soon as each
+// program and all before it have finished; the per-file timings follow on
+// stderr.  Returns the number of programs that failed.
+size_t runBatch(const string &dir, size_t threads, const RunOptions &opts){
+    namespace fs = std::filesystem;
+    vector<BatchJob> jobs;
+    error_code ec;
+    for(fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+        if(it->is_regular_file(ec) && it->path().extension() == ".minilang"){
+            BatchJob job;
+            job.path = it->path().string();
+            jobs.push_back(move(job));
         }
-        else if(auto wh = dynamic_cast<WhileStmt*>(s.get())){ 
-            wh->cond = foldExpr(move(wh->cond)); 
-            foldConstantsInBlock(wh->body.get()); 
+    if(ec){
+        cerr<<"[ERROR] Cannot read directory: "<<dir<<"\n";
+        exit(1);
+    }
+    sort(jobs.begin(), jobs.end(), [](const BatchJob &x, const BatchJob &y){ return x.path < y.path; });
+    threads = max<size_t>(1, min(threads, jobs.size()));
+
+    auto start = chrono::steady_clock::now();
+    BatchPool pool(jobs.size(), threads);
+    vector<char> finished(jobs.size(), 0);
+    mutex lock;
+    condition_variable progress;
+    bool binary = programOut.binary;
+    vector<thread> workers;
+    for(size_t w = 0; w < threads; w++)
+        workers.emplace_back([&, w]{
+            programOut.binary = binary;
+            for(size_t j; pool.take(w, j); ){
+                runBatchJob(jobs[j], opts);
+                lock_guard<mutex> hold(lock);
+                finished[j] = 1;
+                progress.notify_all();
+            }
+        });
+
+    size_t failed = 0;
+    for(size_t j = 0; j < jobs.size(); j++){
+        {
+            unique_lock<mutex> hold(lock);
+            progress.wait(hold, [&]{ return finished[j] != 0; });
         }
-        else if(auto blk2 = dynamic_cast<BlockStmt*>(s.get())) 
-            foldConstantsInBlock(blk2);
-        else if(auto ps = dynamic_cast<PrintStmt*>(s.get())) 
-            ps->e = foldExpr(move(ps->e));
+        BatchJob &job = jobs[j];
+        if(!binary) cout << "=== " << job.path << " ===\n";
+        cout.write(job.output.data(), job.output.size());
+        cout.flush();
+        string().swap(job.output);
+        failed += !job.ok;
+    }
+    for(thread &t : workers) t.join();
+    double wall = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    double busy = 0;
+    size_t width = 4;
+    for(const BatchJob &job : jobs) width = max(width, job.path.size());
+    cerr << "\n=== BATCH SUMMARY ===" << endl << fixed << setprecision(3);
+    cerr << left << setw(width + 2) << "File" << right << setw(12) << "Wall ms" << "  Status" << endl;
+    for(const BatchJob &job : jobs){
+        cerr << left << setw(width + 2) << job.path << right << setw(12) << job.ms << "  " << (job.ok ? "ok" : "FAILED") << endl;
+        busy += job.ms;
     }
-    cout << "[OPTIMIZATION] Constant folding completed!" << endl;
+    cerr << jobs.size() << " files, " << failed << " failed: " << wall << " ms wall, " << busy << " ms in programs on "
+         << threads << " thread" << (threads == 1 ? "" : "s") << endl << defaultfloat << left;
+    return failed;
 }
 
 // ============================================================================
-// PHASE 4 & 6: INTERMEDIATE CODE GENERATION - Three Address Code
+// COMPILE SERVER (--serve)
 // ============================================================================
-struct TACGen {
-    vector<string> code; 
-    int tmpCounter = 0;
-    bool debug;
-    
-    TACGen(bool dbg=false): debug(dbg) {}
-    
-    string newTmp(){ 
-        string tmp = string("t") + to_string(++tmpCounter);
-        if(debug) cout << "[TAC] New temporary: " << tmp << endl;
-        return tmp;
+// A program compiled for one engine.  It is never modified after
+// compileProgram, so any number of requests can run it at the same time.
+struct CompiledProgram {
+    string source;          // the tokens and names point into it
+    char engine;            // 'a' AST, 'v' VM, or '0'..'2': TAC at that -O level
+    Ast ast;
+    TACProgram tac;         // --jit only
+    Bytecode bc;            // --vm only
+};
+
+char engineKey(const RunOptions &opts){
+    return opts.tiered ? '0' + opts.optLevel : opts.useVM ? 'v' : 'a';
+}
+
+// The quiet path of runSource up to (not including) execution.
+shared_ptr<CompiledProgram> compileProgram(string source, const RunOptions &opts){
+    auto c = make_shared<CompiledProgram>();
+    c->source = move(source);
+    c->engine = engineKey(opts);
+    Parser p(c->source);
+    c->ast = p.parseProgram();
+    vector<bool> defined(c->ast.names.size(), false);
+    semanticCheckBlock(c->ast, c->ast.root, defined, false);
+    foldConstantsInBlock(c->ast, c->ast.root, false);
+    if(opts.tiered){
+        TACGen gen(c->ast.names);
+        gen.genProgram(c->ast);
+        if(opts.optLevel > 0) optimizeTAC(gen.prog, opts.optLevel, false, false);
+        c->tac = move(gen.prog);
+    } else if(opts.useVM){
+        BytecodeCompiler bcc(c->ast);
+        c->bc = bcc.compile();
     }
-    
-    string genExpr(Expr* e){
-        if(auto il = dynamic_cast<IntLit*>(e)){
-            return to_string(il->v);
-        } else if(auto ve = dynamic_cast<VarExpr*>(e)){
-            return ve->name;
-        } else if(auto b = dynamic_cast<Binary*>(e)){
-            string A = genExpr(b->a.get()); 
-            string B = genExpr(b->b.get()); 
-            string t = newTmp(); 
-            code.push_back(t + " = " + A + " " + b->op + " " + B); 
-            if(debug) cout << "[TAC] Generated: " << code.back() << endl;
-            return t;
-        }
-        cerr<<"[TAC ERROR] Unhandled expression type\n"; 
-        exit(1);
+    return c;
+}
+
+void runCompiled(const CompiledProgram &c){
+    if(c.engine == 'v'){
+        runBytecode(c.bc);
+    } else if(c.engine == 'a'){
+        Frame env(c.ast.names.size());
+        AstInterpreter(c.ast, env).exec(c.ast.root);
+    } else {
+        TieredExecutor(c.tac).run();
     }
-    
-    void genStmt(Stmt* s){
-        if(auto as = dynamic_cast<AssignStmt*>(s)){
-            string r = genExpr(as->e.get()); 
-            code.push_back(as->name + " = " + r);
-            if(debug) cout << "[TAC] Generated: " << code.back() << endl;
-        } else if(auto ps = dynamic_cast<PrintStmt*>(s)){
-            string r = genExpr(ps->e.get()); 
-            code.push_back(string("print ") + r);
-            if(debug) cout << "[TAC] Generated: " << code.back() << endl;
-        } else if(auto ifs = dynamic_cast<IfStmt*>(s)){
-            string c = genExpr(ifs->cond.get()); 
-            string L1 = string("L") + to_string(code.size()) + "a"; 
-            string L2 = string("L") + to_string(code.size()) + "b";
-            code.push_back(string("ifz ") + c + " goto " + L1);
-            if(debug) cout << "[TAC] Generated: " << code.back() << endl;
-            genBlock(ifs->thenBlock.get()); 
-            code.push_back(string("goto ") + L2);
-            if(debug) cout << "[TAC] Generated: " << code.back() << endl;
-            code.push_back(L1 + ":");
-            if(debug) cout << "[TAC] Generated label: " << code.back() << endl;
-            if(ifs->elseBlock) genBlock(ifs->elseBlock.get());
-            code.push_back(L2 + ":");
-            if(debug) cout << "[TAC] Generated label: " << code.back() << endl;
-        } else if(auto wh = dynamic_cast<WhileStmt*>(s)){
-            string L1 = string("L") + to_string(code.size()) + "a"; 
-            string L2 = string("L") + to_string(code.size()) + "b";
-            code.push_back(L1 + ":");
-            if(debug) cout << "[TAC] Generated label: " << code.back() << endl;
-            string c = genExpr(wh->cond.get()); 
-            code.push_back(string("ifz ") + c + " goto " + L2);
-            if(debug) cout << "[TAC] Generated: " << code.back() << endl;
-            genBlock(wh->body.get()); 
-            code.push_back(string("goto ") + L1);
-            if(debug) cout << "[TAC] Generated: " << code.back() << endl;
-            code.push_back(L2 + ":");
-            if(debug) cout << "[TAC] Generated label: " << code.back() << endl;
-        } else if(auto blk = dynamic_cast<BlockStmt*>(s)){
-            genBlock(blk);
-        } else {
-            cerr<<"[TAC ERROR] Unknown statement type\n"; 
-            exit(1);
+    programOut.flush();
+}
+
+// Compiled programs keyed by a hash of their source and engine; the source
+// is compared as well, so a collision is only a miss.  Once CAPACITY
+// programs are cached the oldest is dropped.
+struct ProgramCache {
+    static constexpr size_t CAPACITY = 256;
+    mutex lock;
+    unordered_map<size_t, shared_ptr<const CompiledProgram>> programs;
+    deque<size_t> order;    // keys, oldest first
+    size_t hits = 0, misses = 0;
+
+    static size_t key(string_view source, char engine){
+        return hash<string_view>()(source) * 31 + engine;
+    }
+
+    shared_ptr<const CompiledProgram> find(string_view source, char engine){
+        lock_guard<mutex> hold(lock);
+        auto it = programs.find(key(source, engine));
+        if(it != programs.end() && it->second->engine == engine && it->second->source == source){
+            hits++;
+            return it->second;
         }
+        misses++;
+        return nullptr;
     }
-    
-    void genBlock(BlockStmt* blk){ 
-        if(debug) cout << "[TAC] Generating code for block with " << blk->stmts.size() << " statements" << endl;
-        for(auto &s : blk->stmts) genStmt(s.get()); 
+
+    void insert(shared_ptr<const CompiledProgram> c){
+        lock_guard<mutex> hold(lock);
+        size_t k = key(c->source, c->engine);
+        if(!programs.count(k)){
+            if(order.size() == CAPACITY){
+                programs.erase(order.front());
+                order.pop_front();
+            }
+            order.push_back(k);
+        }
+        programs[k] = move(c);
     }
 };
 
-// ============================================================================
-// PHASE 6: CODE GENERATION & EXECUTION
-// ============================================================================
-void runSource(const string &source, bool verbose=false, bool debug=false){
-    cout << "=== MINILANG COMPILER EXECUTION ===" << endl;
-    
-    // PHASE 1: Lexical Analysis
-    cout << "\n--- PHASE 1: LEXICAL ANALYSIS ---" << endl;
-    Parser p(source, debug);
-    
-    // PHASE 2: Syntax Analysis  
-    cout << "\n--- PHASE 2: SYNTAX ANALYSIS ---" << endl;
-    auto prog = p.parseProgram();
-    
-    // PHASE 3: Semantic Analysis
-    cout << "\n--- PHASE 3: SEMANTIC ANALYSIS ---" << endl;
-    set<string> defined;
-    semanticCheckBlock(prog.get(), defined);
-    
-    // PHASE 5: Optimization
-    cout << "\n--- PHASE 5: OPTIMIZATION ---" << endl;
-    foldConstantsInBlock(prog.get());
-    
-    // PHASE 4 & 6: Intermediate Code Generation
-    cout << "\n--- PHASE 4 & 6: INTERMEDIATE CODE GENERATION ---" << endl;
-    TACGen gen(debug); 
-    gen.genBlock(prog.get());
-    
-    if(verbose){ 
-        cout << "\n--- THREE ADDRESS CODE ---" << endl;
-        for(auto &l: gen.code) cout << l << "\n"; 
-        cout << "--- END TAC ---" << endl;
+#ifdef MINILANG_HAVE_POSIX
+bool sendAll(int fd, string_view data){
+    while(!data.empty()){
+        ssize_t n = write(fd, data.data(), data.size());
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        data.remove_prefix(n);
     }
-    
-    // PHASE 6: Execution
-    cout << "\n--- PHASE 6: EXECUTION ---" << endl;
-    cout << "Program Output:" << endl;
-    cout << "---------------" << endl;
-    map<string,long long> env;
-    prog->exec(env);
-    cout << "---------------" << endl;
-    cout << "Execution completed!" << endl;
+    return true;
 }
 
-string loadFile(const string &path){ 
-    ifstream in(path); 
-    if(!in) { 
-        cerr<<"[ERROR] Cannot open file: "<<path<<"\n"; 
-        exit(1);
-    } 
-    string s((istreambuf_iterator<char>(in)), istreambuf_iterator<char>()); 
-    return s; 
+// One request: an options line (any of --vm, --jit, -O0..-O2, --binary, and
+// --file when the rest is a path rather than source text), then the rest of
+// the stream up to the client's shutdown(SHUT_WR).  The program's output is
+// written back as it is flushed, then its error if it failed, then a last
+// line "#OK" or "#FAILED".
+void serveClient(int fd, ProgramCache &cache){
+    string request;
+    char chunk[1 << 16];
+    for(ssize_t n; (n = read(fd, chunk, sizeof chunk)) != 0; ){
+        if(n < 0){
+            if(errno == EINTR) continue;
+            return;
+        }
+        request.append(chunk, n);
+    }
+    size_t eol = request.find('\n');
+    string optionLine = request.substr(0, eol);
+    string body = eol == string::npos ? string() : request.substr(eol + 1);
+
+    ostringstream err;
+    RunOptions opts;
+    bool fromFile = false, binary = false, ok = false;
+    istringstream words(optionLine);
+    for(string w; words >> w; ){
+        if(w=="--vm") opts.useVM = true;
+        else if(w=="--jit") opts.tiered = true;
+        else if(w=="-O0" || w=="-O1" || w=="-O2") opts.optLevel = w[2] - '0';
+        else if(w=="--binary") binary = true;
+        else if(w=="--file") fromFile = true;
+        else err<<"[SERVE ERROR] Unknown option '"<<w<<"'\n";
+    }
+    if(err.tellp() == 0){
+        programOut.fd = fd;
+        programOut.binary = binary;
+        jobErrors = &err;
+        try {
+            if(fromFile){
+                while(!body.empty() && (body.back()=='\n' || body.back()=='\r')) body.pop_back();
+                SourceFile file;
+                loadFile(body, file);
+                body.assign(file.text);
+            }
+            shared_ptr<const CompiledProgram> program = cache.find(body, engineKey(opts));
+            if(!program){
+                program = compileProgram(move(body), opts);
+                cache.insert(program);
+            }
+            runCompiled(*program);
+            ok = true;
+        } catch(const JobFailed &){
+            programOut.flush();
+        }
+        jobErrors = nullptr;
+        programOut.fd = STDOUT_FILENO;
+    }
+    sendAll(fd, err.str() + (ok ? "#OK\n" : "#FAILED\n"));
+}
+
+// Accepts clients on a Unix domain socket at `path` and serves each on one
+// of `threads` workers, sharing one cache of compiled programs.  Runs until
+// killed.
+int serve(const string &path, size_t threads){
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof addr.sun_path){
+        cerr<<"[SERVE ERROR] Socket path too long: "<<path<<"\n";
+        return 1;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if(listener < 0 || bind(listener, (sockaddr*)&addr, sizeof addr) < 0 || listen(listener, 128) < 0){
+        cerr<<"[SERVE ERROR] Cannot listen on "<<path<<": "<<strerror(errno)<<"\n";
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);     // a client that hangs up must not kill the server
+
+    ProgramCache cache;
+    mutex lock;
+    condition_variable ready;
+    deque<int> clients;
+    vector<thread> workers;
+    for(size_t w = 0; w < threads; w++)
+        workers.emplace_back([&]{
+            for(;;){
+                int fd;
+                {
+                    unique_lock<mutex> hold(lock);
+                    ready.wait(hold, [&]{ return !clients.empty(); });
+                    fd = clients.front();
+                    clients.pop_front();
+                }
+                serveClient(fd, cache);
+                close(fd);
+            }
+        });
+    cerr << "[SERVE] Listening on " << path << " with " << threads << " worker" << (threads == 1 ? "" : "s") << endl;
+    for(;;){
+        int fd = accept(listener, nullptr, nullptr);
+        if(fd < 0){
+            if(errno == EINTR || errno == ECONNABORTED) continue;
+            cerr<<"[SERVE ERROR] accept: "<<strerror(errno)<<"\n";
+            exit(1);
+        }
+        lock_guard<mutex> hold(lock);
+        clients.push_back(fd);
+        ready.notify_one();
+    }
 }
+#endif
 
+// bench.cpp includes this file for its phases and supplies its own main.
+#ifndef MINILANG_NO_MAIN
 int main(int argc, char **argv){
     string defaultProg = R"MINI(
 // compute fibonacci iteratively and print fib(10)
@@ -773,34 +6240,144 @@ int main(int argc, char **argv){
             cout << "  --spec, -spec    Show language specification\n";
             cout << "  -v               Verbose mode (show TAC)\n";
             cout << "  -d               Debug mode (show all phases)\n";
+            cout << "  --vm             Execute on the bytecode virtual machine\n";
+            cout << "  --jit            Tiered execution: TAC interpreter plus x86-64 JIT for hot loops\n";
+            cout << "  --emit-c FILE    Write the program as a standalone C file\n";
+            cout << "  --native -o FILE Compile the program to a native executable via $CC (default cc)\n";
+            cout << "  -O0, -O1, -O2    SSA optimization of the TAC (-O1: SCCP, copy propagation, DCE;\n";
+            cout << "                   -O2 adds LICM, global value numbering and strength reduction); default -O0\n";
+            cout << "  --count          Interpret the TAC (no JIT) and report how many instructions ran\n";
+            cout << "  --bench-lexer    Only tokenize the file and report lexer throughput in MB/s\n";
+            cout << "  --stream         Read the file in chunks and run each top-level statement as soon as\n";
+            cout << "                   it is parsed (AST interpreter; memory bounded by the largest statement)\n";
+            cout << "  --quiet, -q      Print program output only (no phase banners or analysis traces)\n";
+            cout << "  --binary         Like --quiet, but print raw little-endian int64 values (interpreters only)\n";
+            cout << "  --profile        Report wall time and allocations per phase, and executions and time per\n";
+            cout << "                   statement by source line (AST interpreter), on stderr\n";
+            cout << "  --profile-json FILE  Like --profile, and also write the report to FILE as JSON\n";
+            cout << "  --cache DIR      With --vm, --jit or --count: run the compiled program stored in DIR for\n";
+            cout << "                   this source if there is one, else compile it and store it there (.mlc)\n";
+            cout << "  --batch DIR      Compile and run every .minilang file under DIR in-process, printing\n";
+            cout << "                   the outputs in path order and a per-file timing summary on stderr\n";
+            cout << "  --serve SOCKET   Run as a compile server on a Unix domain socket (see menu.cpp for a client)\n";
+            cout << "  -j N             Worker threads for --batch and --serve, and for loops whose iterations are\n";
+            cout << "                   independent (AST interpreter; default: one per core, -j 1 runs them sequentially)\n";
+            cout << "  --no-simd        Run counted loops with straight-line bodies one iteration at a time instead\n";
+            cout << "                   of in batches through AVX2 (or portable) lane kernels\n";
+            cout << "  --bigint         Arbitrary-precision integers instead of wrapping 64-bit ones (AST\n";
+            cout << "                   interpreter, also with --stream; values up to 2^62 stay inline)\n";
             cout << "  --help, -h       Show this help\n";
             return 0;
         }
     }
 
-    string source;
-    bool verbose = false;
-    bool debug = false;
+    string_view source;
+    string path;
+    SourceFile file;
+    RunOptions opts;
+    bool haveFile = false;
+    bool nativeRequested = false;
+    bool batch = false;
+    string servePath;
+    size_t threads = max(1u, thread::hardware_concurrency());
     
-    if(argc >= 2){ 
-        string arg = argv[1]; 
-        if(arg=="-v") { 
-            verbose=true; 
-            if(argc>=3) source = loadFile(argv[2]); 
-            else source = defaultProg; 
-        } 
+    for(int ai = 1; ai < argc; ai++){ 
+        string arg = argv[ai]; 
+        if(arg=="-v") opts.verbose = true;
         else if(arg=="-d") {
-            debug = true;
-            verbose = true;
-            if(argc>=3) source = loadFile(argv[2]); 
-            else source = defaultProg;
+            opts.debug = true;
+            opts.verbose = true;
+        }
+        else if(arg=="--vm") opts.useVM = true;
+        else if(arg=="--jit") opts.tiered = true;
+        else if(arg=="--emit-c" && ai+1 < argc) opts.emitCPath = argv[++ai];
+        else if(arg=="--native") nativeRequested = true;
+        else if(arg=="-o" && ai+1 < argc) opts.nativeOut = argv[++ai];
+        else if(arg=="-O0" || arg=="-O1" || arg=="-O2") opts.optLevel = arg[2] - '0';
+        else if(arg=="--count") opts.countInstrs = true;
+        else if(arg=="--bench-lexer") opts.lexBench = true;
+        else if(arg=="--stream") opts.stream = true;
+        else if(arg=="--quiet" || arg=="-q") opts.quiet = true;
+        else if(arg=="--binary") opts.quiet = programOut.binary = true;
+        else if(arg=="--profile") opts.profile = true;
+        else if(arg=="--profile-json" && ai+1 < argc) {
+            opts.profile = true;
+            opts.profileJson = argv[++ai];
         }
-        else { 
-            source = loadFile(arg); 
+        else if(arg=="--batch") batch = true;
+        else if(arg=="--cache" && ai+1 < argc) opts.cacheDir = argv[++ai];
+        else if(arg=="--serve" && ai+1 < argc) servePath = argv[++ai];
+        else if(arg=="-j" && ai+1 < argc) threads = max(1, atoi(argv[++ai]));
+        else if(arg=="--bigint") opts.bigint = true;
+        else if(arg=="--no-simd") opts.simd = false;
+        else if(!haveFile) { 
+            path = arg;
+            haveFile = true;
         } 
     }
+    opts.loopThreads = threads;
+    cerr.tie(&programOutTie);
+    // Print output is line-buffered for terminals and -d traces, like stdio.
+#ifdef MINILANG_HAVE_POSIX
+    programOut.lineFlush = !programOut.binary && (opts.debug || isatty(STDOUT_FILENO));
+#else
+    programOut.lineFlush = opts.debug;
+#endif
+    if(!servePath.empty()){
+#ifdef MINILANG_HAVE_POSIX
+        return serve(servePath, threads);
+#else
+        cerr<<"[ERROR] --serve needs a POSIX system\n";
+        return 1;
+#endif
+    }
+    if(batch){
+        if(!haveFile){
+            cerr<<"[ERROR] --batch needs a directory\n";
+            exit(1);
+        }
+        if(opts.debug || opts.verbose || opts.profile || opts.countInstrs || opts.stream || opts.lexBench || opts.bigint || nativeRequested || !opts.emitCPath.empty())
+            cerr << "[BATCH] Only --vm, --jit, -O and --binary apply to --batch; other options ignored" << endl;
+        RunOptions jobOpts;
+        jobOpts.quiet = true;
+        jobOpts.useVM = opts.useVM;
+        jobOpts.tiered = opts.tiered;
+        jobOpts.optLevel = opts.optLevel;
+        return runBatch(path, threads, jobOpts) ? 1 : 0;
+    }
+    if(opts.bigint && (opts.useVM || opts.tiered || opts.countInstrs || opts.optLevel || !opts.cacheDir.empty()
+                       || nativeRequested || !opts.emitCPath.empty())){
+        cerr << "[BIGINT] --bigint runs on the AST interpreter; --vm, --jit, --count, -O, --cache, --emit-c and --native ignored" << endl;
+        opts.useVM = opts.tiered = opts.countInstrs = nativeRequested = false;
+        opts.optLevel = 0;
+        opts.cacheDir.clear();
+        opts.emitCPath.clear();
+    }
+    if(opts.stream){
+        StreamSource in;
+        if(!haveFile) in.buf = defaultProg;
+        else if(!(in.in = fopen(path.c_str(), "rb"))){
+            cerr<<"[ERROR] Cannot open file: "<<path<<"\n";
+            exit(1);
+        }
+        if(opts.profile) cerr << "[PROFILE] --profile is not available with --stream; ignored" << endl;
+        return runStream(in, opts) ? 0 : 1;
+    }
+    if(haveFile){
+        loadFile(path, file);
+        source = file.text;
+    }
     else source = defaultProg;
+    if(nativeRequested && opts.nativeOut.empty()) opts.nativeOut = "a.out";
+    if(!nativeRequested) opts.nativeOut.clear();
 
-    runSource(source, verbose, debug);
-    return 0;
-}
\ No newline at end of file
+    if(opts.lexBench) return benchLexer(source) ? 0 : 1;
+    if(!opts.cacheDir.empty()){
+        if(!cacheEngine(opts) || opts.verbose || opts.profile || !opts.emitCPath.empty() || !opts.nativeOut.empty()){
+            cerr << "[CACHE] --cache needs --vm, --jit or --count and no -v, -d, --profile or native output; ignored" << endl;
+            opts.cacheDir.clear();
+        } else if(runCached(source, opts)) return 0;
+    }
+    return runSource(source, opts) ? 0 : 1;
+}
+#endif
@@ -4,7 +4,7 @@ echo "Setting up MiniLang Pattern Generator..."
 
 # Compile the compiler
 echo "Compiling MiniLang compiler..."
-g++ minilang.cpp -o minilang -std=c++17
+g++ minilang.cpp -o minilang -std=c++17 -O2 -pthread
 
 if [ $? -ne 0 ]; then
     echo "Error: Failed to compile MiniLang compiler!"
@@ -99,5 +99,14 @@ if [ $? -ne 0 ]; then
     exit 1
 fi
 
+# Compile benchmark harness
+echo "Compiling benchmark harness..."
+g++ bench.cpp -o bench -std=c++17 -O2 -pthread
+
+if [ $? -ne 0 ]; then
+    echo "Error: Failed to compile benchmark harness!"
+    exit 1
+fi
+
 echo "Setup complete!"
 echo "Run './menu' to start the MiniLang Pattern Generator"
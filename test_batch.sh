@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Batch isolation check: runs tests/batch, where failing programs sit next
+# to a good one, on every engine and checks that each program's output and
+# error appear in path order and that only the failing files are marked.
+
+MINILANG=${MINILANG:-./minilang}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ ! -x "$MINILANG" ]; then
+    echo "Error: $MINILANG not found; run ./setup.sh first"
+    exit 1
+fi
+
+cat > "$WORK/expected" << 'OUT'
+=== tests/batch/div_overflow.minilang ===
+[RUNTIME ERROR] Division overflow
+=== tests/batch/good.minilang ===
+120
+=== tests/batch/mod_zero.minilang ===
+7
+[RUNTIME ERROR] Division by zero
+OUT
+
+status=0
+for engine in "" "--vm" "--jit"; do
+    "$MINILANG" --batch tests/batch -j 2 $engine > "$WORK/out" 2> "$WORK/summary"
+    rc=$?
+    name=${engine:-ast}
+    if [ $rc -ne 1 ]; then
+        echo "FAIL $name: exit status $rc, expected 1"
+        status=1
+    elif ! diff -u "$WORK/expected" "$WORK/out"; then
+        echo "FAIL $name: output differs"
+        status=1
+    elif ! grep -q "3 files, 2 failed" "$WORK/summary"; then
+        echo "FAIL $name: summary missing"
+        status=1
+    else
+        echo "ok   $name"
+    fi
+done
+exit $status